@@ -196,20 +196,10 @@ HTTP_SETUP(example, app) {
 
     app.Delete("/delete_route").args(arg::arg("path"), arg::default_val("method", ""))|
     [&](std::string path, std::string method) -> Result<void> {
-        auto [begin, end] = app.routers.equal_range(path);
-        bool found = false;
-
-        for (auto it = begin; it != end;) {
-            auto &router = it->second;
-            if (method.empty() || std::find(router.methods.begin(), router.methods.end(), method) != router.methods.end()) {
-                found = true;
-                it = app.routers.erase(it);
-            } else {
-                ++it;
-            }
+        if (not RouteTree::is_valid(path)) {
+            return Err(Error{StatusBadRequest, "path " + path + " is not a valid route"});
         }
-
-        if (found) {
+        if (app.routers.erase(path, method) > 0) {
             return Ok();
         } else {
             return Err(Error{StatusBadRequest, method + " " + path + " not found"});
@@ -54,6 +54,7 @@ static HTTP_ROUTE(
 ) {
     return File::Open(FL, File::Args{filename}).then([&](File file) {
         res->headers["Content-Type"] = delameta::get_content_type_from_file(filename);
+        res->headers["Content-Length"] = std::to_string(file.file_size());
         file >> res->body_stream;
     });
 }
@@ -77,7 +78,10 @@ static HTTP_ROUTE(
         (std::string, filename, http::arg::arg("filename")),
     (http::Result<void>)
 ) {
-    if (app.routers.find(path) != app.routers.end()) {
+    if (not http::RouteTree::is_valid(path)) {
+        return Err(http::Error{http::StatusBadRequest, "path " + path + " is not a valid route"});
+    }
+    if (app.routers.contains(path)) {
         return Err(http::Error{http::StatusConflict, "path " + path + " is already exist"});
     }
 
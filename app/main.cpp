@@ -68,6 +68,7 @@ OPTS_MAIN(
     }
 
     Opts::verbose = verbose;
+    delameta::set_log_level(verbose ? delameta::LogLevel::Info : delameta::LogLevel::Warning);
 
     // launch http server if cmd and url are not specified
     if (cmd == "" and url_str == "") {
@@ -11,7 +11,7 @@ using etl::Err;
 using etl::Ref;
 
 HTTP_SETUP(readme_setup, app) {
-    app.Static("/docs", "/usr/share/doc/delameta/html");
+    app.Static("/docs", "/usr/share/doc/delameta/html", {.mount=true, .cache_size=256});
 }
 
 static HTTP_ROUTE(
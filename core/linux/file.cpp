@@ -3,7 +3,8 @@
 #include <cstring>
 #include <algorithm>
 #include <fcntl.h>
-#include <unistd.h> // lseek
+#include <sys/stat.h>
+#include <unistd.h> // lseek, pread
 
 #ifndef MAX_HANDLE_SZ
 #define MAX_HANDLE_SZ 128
@@ -20,7 +21,7 @@ using etl::defer;
 static auto log_errno(const char* file, int line) {
     int code = errno;
     std::string what = ::strerror(code);
-    warning(file, line, what);
+    WARNING_AT(file, line, what);
     return Err(Error{code, std::move(what)});
 }
 
@@ -40,7 +41,7 @@ auto File::Open(const char* file, int line, Args args) -> Result<File> {
         __oflag = O_RDWR | O_APPEND | O_CREAT;
     } else {
         Error err = {-1, "Invalid mode. expect `r`, `w`, `wa`, `rw` or `rwa`, given `" + args.mode + "`"};
-        warning(file, line, err.what);
+        WARNING_AT(file, line, err.what);
         return Err(std::move(err));
     }
 
@@ -48,7 +49,7 @@ auto File::Open(const char* file, int line, Args args) -> Result<File> {
     if (fd < 0) {
         return log_errno(file, line);
     } else {
-        info(file, line, delameta_detail_log_format_fd(fd, "created"));
+        INFO_AT(file, line, delameta_detail_log_format_fd(fd, "created"));
         return Ok(File(file, line, fd));
     }
 }
@@ -68,16 +69,24 @@ File::File(File&& other)
 File::~File() {
     if (fd < 0) return;
     ::close(fd);
-    info(file, line, delameta_detail_log_format_fd(fd, "closed"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "closed"));
     fd = -1;
 }
 
 auto File::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read(file, line, fd, nullptr, -1, &delameta_detail_is_fd_alive);
+    return delameta_detail_read(file, line, fd, nullptr, -1);
 }
 
 auto File::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read_until(file, line, fd, nullptr, -1, &delameta_detail_is_fd_alive, n);
+    return delameta_detail_read_until(file, line, fd, nullptr, -1, n);
+}
+
+auto File::read_buffer() -> Result<Buffer> {
+    return delameta_detail_read_buffer(file, line, fd, nullptr, -1);
+}
+
+auto File::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return delameta_detail_read_into(file, line, fd, nullptr, -1, deadline, buf, cap);
 }
 
 auto File::read_as_stream(size_t n) -> Stream {
@@ -85,7 +94,15 @@ auto File::read_as_stream(size_t n) -> Stream {
 }
 
 auto File::write(std::string_view data) -> Result<void> {
-    return delameta_detail_write(file, line, fd, nullptr, -1, &delameta_detail_is_fd_alive, data);
+    return delameta_detail_write(file, line, fd, nullptr, -1, false, data);
+}
+
+auto File::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return delameta_detail_writev(file, line, fd, -1, false, data, n);
+}
+
+auto File::write_from_fd(int in_fd, size_t n, int64_t offset) -> Result<size_t> {
+    return delameta_detail_splice(file, line, fd, in_fd, n, offset);
 }
 
 auto File::file_size() -> size_t {
@@ -106,6 +123,31 @@ auto File::file_size() -> size_t {
     return size;
 }
 
+static auto to_stat(const struct stat& st) -> File::Stat {
+    return {
+        .size=static_cast<size_t>(st.st_size),
+        .mtime_ns=int64_t(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec,
+        .id=static_cast<uint64_t>(st.st_ino),
+    };
+}
+
+auto File::stat() -> Result<Stat> {
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        return log_errno(file, line);
+    }
+    return Ok(to_stat(st));
+}
+
+auto File::stat(const std::string& filename) -> Result<Stat> {
+    struct stat st;
+    if (::stat(filename.c_str(), &st) < 0) {
+        int code = errno;
+        return Err(Error{code, ::strerror(code)});
+    }
+    return Ok(to_stat(st));
+}
+
 auto File::operator<<(Stream& other) -> File& {
     other >> *this;
     return *this;
@@ -115,7 +157,21 @@ auto File::operator>>(Stream& s) -> File& {
     auto total = file_size();
     auto self = new File(std::move(*this));
 
-    s << [self, total, buffer=std::vector<uint8_t>{}](Stream& s) mutable -> std::string_view {
+    s << [self, total, buffer=std::vector<uint8_t>{}, zero_copy=true](Stream& s) mutable -> std::string_view {
+        // hand the file straight to the destination if it can take it, e.g. sendfile() into a TCP socket
+        if (zero_copy and s.sink) {
+            auto res = s.sink->write_from_fd(self->fd, total);
+            if (res.is_ok() and res.unwrap() > 0) {
+                total -= std::min(total, res.unwrap());
+                s.again = total > 0;
+                if (!s.again) {
+                    delete self;
+                }
+                return {};
+            }
+            zero_copy = false;
+        }
+
         size_t n = std::min(total, (size_t)MAX_HANDLE_SZ);
         auto data = self->read_until(n);
 
@@ -135,3 +191,36 @@ auto File::operator>>(Stream& s) -> File& {
 
     return *this;
 }
+
+void File::stream_at(std::shared_ptr<File> file, Stream& s, size_t offset, size_t n, std::function<void()> on_error) {
+    s << [file=std::move(file), offset, n, on_error=std::move(on_error), buffer=std::vector<uint8_t>{}, zero_copy=true](Stream& s) mutable -> std::string_view {
+        if (n == 0) return {};
+
+        if (zero_copy and s.sink) {
+            auto res = s.sink->write_from_fd(file->fd, n, offset);
+            if (res.is_ok() and res.unwrap() > 0) {
+                auto moved = std::min(n, res.unwrap());
+                offset += moved;
+                n -= moved;
+                s.again = n > 0;
+                return {};
+            }
+            zero_copy = false;
+        }
+
+        buffer.resize(std::min(n, (size_t)MAX_HANDLE_SZ));
+        auto read = ::pread(file->fd, buffer.data(), buffer.size(), offset);
+        if (read <= 0) {
+            // the file got shorter or can't be read, the bytes promised to the reader won't come
+            s.again = false;
+            s.failed = true;
+            if (on_error) on_error();
+            return {};
+        }
+
+        offset += read;
+        n -= read;
+        s.again = n > 0;
+        return {reinterpret_cast<const char*>(buffer.data()), static_cast<size_t>(read)};
+    };
+}
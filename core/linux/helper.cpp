@@ -1,9 +1,11 @@
 #include <cstring>
 #include <fmt/format.h>
 #include <iostream>
-#include <thread>
+#include <chrono>
 #include <etl/string_view.h>
 #include <algorithm>
+#include <optional>
+#include <thread>
 #include "delameta/stream.h"
 #include "delameta/url.h"
 #include "helper.h"
@@ -11,10 +13,16 @@
 // Unix/Linux headers and definitions
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #define IOCTL ::ioctl
 
 #ifndef DELAMETA_DISABLE_OPENSSL
@@ -39,6 +47,7 @@ using namespace std::literals;
 
 using etl::Err;
 using etl::Ok;
+using etl::defer;
 
 int delameta_detail_set_non_blocking(int socket) {
     return ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
@@ -50,18 +59,6 @@ bool delameta_detail_is_fd_alive(int fd) {
     return ::fcntl(fd, F_GETFD) != -1 || errno != EBADF;
 }
 
-bool delameta_detail_is_socket_alive(int socket) {
-    char dummy;
-    int res = ::recv(socket, &dummy, 1, MSG_PEEK);
-    if (res == 0)
-        return false; // connection close
-    if (res > 0)
-        return true; // data available, socket is alive
-    if (auto errno_ = errno; res < 0 && (errno_ == EWOULDBLOCK || errno_ == EINPROGRESS))
-        return true; // no data available, socket is alive
-    return false;
-}
-
 auto delameta_detail_get_ip(int socket) -> std::string {
     sockaddr_storage addr;
     socklen_t addr_len = sizeof(addr);
@@ -175,134 +172,343 @@ auto delameta_detail_resolve_domain(const std::string& domain, int sock_type, bo
 }
 
 static auto log_err(const char* file, int line, int fd, Error err) {
-    warning(file, line, delameta_detail_log_format_fd(fd, err.what));
+    WARNING_AT(file, line, delameta_detail_log_format_fd(fd, err.what));
     return Err(std::move(err));
 }
 
 static auto log_received_ok(const char* file, size_t line, int fd, std::vector<uint8_t>& res) {
-    info(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(res.size()) + " bytes"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(res.size()) + " bytes"));
     return Ok(std::move(res));
 }
 
 static auto log_sent_ok(const char* file, size_t line, int fd, size_t n) {
-    info(file, line, delameta_detail_log_format_fd(fd, "written " + std::to_string(n) + " bytes"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "written " + std::to_string(n) + " bytes"));
     return Ok();
 }
 
 [[maybe_unused]] static auto log_err(const char* file, int line, Error err) {
-    warning(file, line, err.what);
+    WARNING_AT(file, line, err.what);
     return Err(std::move(err));
 }
 
 [[maybe_unused]] static auto log_received_ok(const char* file, size_t line, std::vector<uint8_t>& res) {
-    info(file, line, "read " + std::to_string(res.size()) + " bytes");
+    INFO_AT(file, line, "read " + std::to_string(res.size()) + " bytes");
     return Ok(std::move(res));
 }
 
 [[maybe_unused]] static auto log_sent_ok(const char* file, size_t line, size_t n) {
-    info(file, line, "written " + std::to_string(n) + " bytes");
+    INFO_AT(file, line, "written " + std::to_string(n) + " bytes");
     return Ok();
 }
 
-auto delameta_detail_read(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int)) -> Result<std::vector<uint8_t>> {
-    auto start = std::chrono::high_resolution_clock::now();
+using Clock = std::chrono::steady_clock;
+
+// `timeout_ms` after `start`, a negative timeout never expires
+static Clock::time_point deadline_of(Clock::time_point start, int timeout_ms) {
+    return timeout_ms < 0 ? Clock::time_point::max() : start + std::chrono::milliseconds(timeout_ms);
+}
+
+// the deadline given to read_into(), a default constructed one falls back to the descriptor's `timeout_ms`
+static Clock::time_point resolve_deadline(Deadline deadline, int timeout_ms) {
+    return deadline == Deadline{} ? deadline_of(Clock::now(), timeout_ms) : deadline;
+}
+
+// remaining time until `deadline` in milliseconds, rounded up. -1 means wait forever
+static int remaining_ms(Clock::time_point deadline) {
+    if (deadline == Clock::time_point::max()) return -1;
+    auto left = deadline - Clock::now();
+    if (left <= Clock::duration::zero()) return 0;
+    return std::chrono::ceil<std::chrono::milliseconds>(left).count();
+}
+
+static int remaining_ms(Clock::time_point start, int timeout_ms) {
+    return remaining_ms(deadline_of(start, timeout_ms));
+}
+
+int delameta_detail_wait_fd(int fd, short events, int timeout_ms) {
+    struct pollfd pfd = {fd, events, 0};
+    return ::poll(&pfd, 1, timeout_ms);
+}
+
+// block until `fd` becomes readable, the peer hangs up, or the deadline expires
+static auto wait_readable(const char* file, int line, int fd, Clock::time_point deadline) -> Result<void> {
+    for (;;) {
+        int res = delameta_detail_wait_fd(fd, POLLIN, remaining_ms(deadline));
+        if (res > 0) {
+            return Ok();
+        } else if (res == 0) {
+            return log_err(file, line, fd, Error::TransferTimeout);
+        } else if (auto errno_ = errno; errno_ != EINTR) {
+            return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+        }
+    }
+}
+
+static auto wait_readable(const char* file, int line, int fd, Clock::time_point start, int timeout_ms) -> Result<void> {
+    return wait_readable(file, line, fd, deadline_of(start, timeout_ms));
+}
+
+// wait until `fd` has data and read all of it, at most `cap` bytes, into the storage handed out by `reserve(n)`.
+// returns the number of bytes read
+static auto read_available(
+    const char* file, int line, int fd, [[maybe_unused]] void* ssl, Clock::time_point deadline, 
+    size_t cap, const std::function<uint8_t*(size_t)>& reserve
+) -> Result<size_t> {
     unsigned long bytes_available = 0;
 
 #ifndef DELAMETA_DISABLE_OPENSSL
     auto ssl_ = reinterpret_cast<SSL*>(ssl);
 #endif
 
-    while (is_alive(fd)) {
-        if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
-            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
-        }
-
+    for (;;) {
+#ifndef DELAMETA_DISABLE_OPENSSL
+        // decrypted bytes may already be buffered inside the SSL object
+        bytes_available = ssl ? SSL_pending(ssl_) : 0;
+#endif
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
-                return log_err(file, line, fd, Error::TransferTimeout);
+            auto [_, wait_err] = wait_readable(file, line, fd, deadline);
+            if (wait_err) return Err(std::move(*wait_err));
+
+            if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
+                return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+            }
+
+            if (bytes_available == 0) {
+                // readable without any data means end of file or the peer has closed the connection
+                break;
             }
-            std::this_thread::sleep_for(10ms);
-            continue;
         }
 
-        std::vector<uint8_t> buffer(bytes_available);
+        bytes_available = std::min<size_t>(bytes_available, cap);
+        auto buffer = reserve(bytes_available);
 
 #ifndef DELAMETA_DISABLE_OPENSSL
-        auto size = ssl ? SSL_read(ssl_, buffer.data(), bytes_available) : ::read(fd, buffer.data(), bytes_available);
+        auto size = ssl ? SSL_read(ssl_, buffer, bytes_available) : ::read(fd, buffer, bytes_available);
+        if (ssl && size <= 0 && SSL_get_error(ssl_, size) == SSL_ERROR_WANT_READ) {
+            bytes_available = 0;
+            continue; // incomplete TLS record, wait for the rest
+        }
 #else
-        auto size = ::read(fd, (char*)buffer.data(), bytes_available);
+        auto size = ::read(fd, buffer, bytes_available);
 #endif
         if (size < 0) {
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
-        buffer.resize(size);
-        return log_received_ok(file, line, fd, buffer);
+        return Ok(size_t(size));
     }
 
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout, void *peer) -> Result<std::vector<uint8_t>> {
-    auto start = std::chrono::high_resolution_clock::now();
-    unsigned long bytes_available = 0;
+auto delameta_detail_read(const char* file, int line, int fd, void* ssl, int timeout_ms) -> Result<std::vector<uint8_t>> {
+    std::vector<uint8_t> buffer;
+    auto deadline = deadline_of(Clock::now(), timeout_ms);
+    auto [size, err] = read_available(file, line, fd, ssl, deadline, SIZE_MAX, [&buffer](size_t n) {
+        buffer.resize(n);
+        return buffer.data();
+    });
+    if (err) return Err(std::move(*err));
+
+    buffer.resize(*size);
+    return log_received_ok(file, line, fd, buffer);
+}
+
+auto delameta_detail_read_buffer(const char* file, int line, int fd, void* ssl, int timeout_ms) -> Result<Buffer> {
+    Buffer buffer;
+    auto deadline = deadline_of(Clock::now(), timeout_ms);
+    auto [size, err] = read_available(file, line, fd, ssl, deadline, SIZE_MAX, [&buffer](size_t n) {
+        buffer = Buffer::acquire(n);
+        return buffer.data();
+    });
+    if (err) return Err(std::move(*err));
+
+    buffer.resize(*size);
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(*size) + " bytes"));
+    return Ok(std::move(buffer));
+}
 
-    while (delameta_detail_is_socket_alive(fd)) {
+auto delameta_detail_read_into(
+    const char* file, int line, int fd, void* ssl, int timeout_ms, Deadline deadline, uint8_t* buf, size_t cap
+) -> Result<size_t> {
+    if (cap == 0) return Ok(0);
+
+    auto [size, err] = read_available(file, line, fd, ssl, resolve_deadline(deadline, timeout_ms), cap, [buf](size_t) {
+        return buf;
+    });
+    if (err) return Err(std::move(*err));
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(*size) + " bytes"));
+    return Ok(*size);
+}
+
+// read one frame into the storage handed out by `reserve(have, n)`, which is room for `n` more bytes after the `have`
+// bytes read so far. `reserve` may cut `n` down, the frame ends early once it is cut to zero. the frame also ends at
+// `deadline` once something has been read, so a line that never goes silent can't hold the reader
+static auto read_frame_available(
+    const char* file, int line, int fd, Clock::time_point deadline, int gap_us, 
+    const std::function<uint8_t*(size_t, size_t&)>& reserve
+) -> Result<size_t> {
+    auto [_, wait_err] = wait_readable(file, line, fd, deadline);
+    if (wait_err) return Err(std::move(*wait_err));
+
+    const struct timespec gap = {gap_us / 1'000'000, (gap_us % 1'000'000) * 1000L};
+    size_t have = 0;
+
+    for (;;) {
+        unsigned long bytes_available = 0;
         if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
-                return log_err(file, line, fd, Error::TransferTimeout);
+            // readable without any data means the line has hung up
+            if (have == 0) return log_err(file, line, fd, Error::ConnectionClosed);
+            break;
+        }
+
+        size_t n = bytes_available;
+        auto buffer = reserve(have, n);
+        if (n == 0) {
+            break;
+        }
+
+        auto size = ::read(fd, buffer, n);
+        if (size < 0) {
+            if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINTR) {
+                return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
             }
-            std::this_thread::sleep_for(10ms);
-            continue;
+            size = 0;
+        }
+        have += size;
+        if (Clock::now() >= deadline) break;
+
+        // the frame ends after `gap` of silence on the line
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int res = ::ppoll(&pfd, 1, &gap, nullptr);
+        if (res == 0) {
+            break;
+        } else if (auto errno_ = errno; res < 0 && errno_ != EINTR) {
+            return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+        }
+    }
+
+    return Ok(have);
+}
+
+auto delameta_detail_read_frame(const char* file, int line, int fd, int timeout_ms, int gap_us, size_t max_size) -> Result<std::vector<uint8_t>> {
+    std::vector<uint8_t> buffer;
+    auto deadline = deadline_of(Clock::now(), timeout_ms);
+    auto [size, err] = read_frame_available(file, line, fd, deadline, gap_us, [&buffer, max_size](size_t have, size_t& n) {
+        n = std::min(n, max_size - have);
+        buffer.resize(have + n);
+        return buffer.data() + have;
+    });
+    if (err) return Err(std::move(*err));
+
+    buffer.resize(*size);
+    return log_received_ok(file, line, fd, buffer);
+}
+
+auto delameta_detail_read_frame_into(
+    const char* file, int line, int fd, int timeout_ms, Deadline deadline, int gap_us, uint8_t* buf, size_t cap
+) -> Result<size_t> {
+    if (cap == 0) return Ok(0);
+
+    auto [size, err] = read_frame_available(file, line, fd, resolve_deadline(deadline, timeout_ms), gap_us, [buf, cap](size_t have, size_t& n) {
+        n = std::min(n, cap - have);
+        return buf + have;
+    });
+    if (err) return Err(std::move(*err));
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(*size) + " bytes"));
+    return Ok(*size);
+}
+
+// receive the next datagram, at most `cap` bytes of it, into the storage handed out by `reserve(n)`. the rest of a
+// longer datagram is discarded. returns the number of bytes received
+static auto recv_datagram(
+    const char* file, int line, int fd, Clock::time_point deadline, void *peer, 
+    size_t cap, const std::function<uint8_t*(size_t)>& reserve
+) -> Result<size_t> {
+    unsigned long bytes_available = 0;
+
+    for (;;) {
+        auto [_, wait_err] = wait_readable(file, line, fd, deadline);
+        if (wait_err) return Err(std::move(*wait_err));
+
+        // for datagram sockets this is the size of the next pending datagram
+        if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
+            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
-        std::vector<uint8_t> buffer(bytes_available);
+        bytes_available = std::min<size_t>(bytes_available, cap);
+        auto buffer = reserve(bytes_available);
         auto peer_ = reinterpret_cast<struct addrinfo *>(peer);
         socklen_t len_ = peer_->ai_addrlen;
-        auto size = ::recvfrom(fd, (char*)buffer.data(), bytes_available, 0, peer_->ai_addr, &len_);
+        auto size = ::recvfrom(fd, (char*)buffer, bytes_available, 0, peer_->ai_addr, &len_);
         if (size < 0) {
+            if (auto errno_ = errno; errno_ == EWOULDBLOCK || errno_ == EINTR) continue;
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
-        buffer.resize(size);
-        return log_received_ok(file, line, fd, buffer);
+        return Ok(size_t(size));
     }
+}
 
-    return log_err(file, line, fd, Error::ConnectionClosed);
+auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout_ms, void *peer) -> Result<std::vector<uint8_t>> {
+    std::vector<uint8_t> buffer;
+    auto deadline = deadline_of(Clock::now(), timeout_ms);
+    auto [size, err] = recv_datagram(file, line, fd, deadline, peer, SIZE_MAX, [&buffer](size_t n) {
+        buffer.resize(n);
+        return buffer.data();
+    });
+    if (err) return Err(std::move(*err));
+
+    buffer.resize(*size);
+    return log_received_ok(file, line, fd, buffer);
 }
 
-auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int), size_t n) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_recvfrom_into(
+    const char* file, int line, int fd, int timeout_ms, Deadline deadline, void *peer, uint8_t* buf, size_t cap
+) -> Result<size_t> {
+    auto [size, err] = recv_datagram(file, line, fd, resolve_deadline(deadline, timeout_ms), peer, cap, [buf](size_t) {
+        return buf;
+    });
+    if (err) return Err(std::move(*err));
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(*size) + " bytes"));
+    return Ok(*size);
+}
+
+auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout_ms, size_t n) -> Result<std::vector<uint8_t>> {
 #ifndef DELAMETA_DISABLE_OPENSSL
     if (ssl) { // cannot read parsial data
-        return delameta_detail_read(file, line, fd, ssl, timeout, is_alive);
+        return delameta_detail_read(file, line, fd, ssl, timeout_ms);
     }
 #endif
 
-    auto start = std::chrono::high_resolution_clock::now();
+    auto start = Clock::now();
     std::vector<uint8_t> buffer(n);
 
-    int remaining_size = n;
+    size_t remaining_size = n;
     unsigned long bytes_available = 0;
     auto ptr = buffer.data();
 
-    while (is_alive(fd)) {
+    for (;;) {
+        auto [_, wait_err] = wait_readable(file, line, fd, start, timeout_ms);
+        if (wait_err) return Err(std::move(*wait_err));
+
         if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
-                return log_err(file, line, fd, Error::TransferTimeout);
-            }
-            std::this_thread::sleep_for(10ms);
-            continue;
+            // readable without any data means end of file or the peer has closed the connection
+            break;
         }
 
-        auto size = ::read(fd, ptr, std::min((int)bytes_available, remaining_size));
+        auto size = ::read(fd, ptr, std::min<size_t>(bytes_available, remaining_size));
         if (size < 0) {
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
@@ -310,7 +516,7 @@ auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unus
         ptr += size;
         remaining_size -= size;
 
-        if (remaining_size <= 0) {
+        if (remaining_size == 0) {
             return log_received_ok(file, line, fd, buffer);
         }
     }
@@ -318,48 +524,55 @@ auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unus
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int timeout, void *peer, size_t n) -> Result<std::vector<uint8_t>> {
-    auto start = std::chrono::high_resolution_clock::now();
+auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int timeout_ms, void *peer, size_t n) -> Result<std::vector<uint8_t>> {
+    auto start = Clock::now();
     std::vector<uint8_t> buffer(n);
 
-    int remaining_size = n;
-    unsigned long bytes_available = 0;
+    size_t remaining_size = n;
+    auto ptr = buffer.data();
 
-    while (delameta_detail_is_socket_alive(fd)) {
-        if (IOCTL(fd, FIONREAD, &bytes_available) == -1) {
-            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
-        }
-
-        if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
-                return log_err(file, line, fd, Error::TransferTimeout);
-            }
-            std::this_thread::sleep_for(10ms);
-            continue;
-        }
+    for (;;) {
+        auto [_, wait_err] = wait_readable(file, line, fd, start, timeout_ms);
+        if (wait_err) return Err(std::move(*wait_err));
 
         auto peer_ = reinterpret_cast<struct addrinfo *>(peer);
         socklen_t len_ = peer_->ai_addrlen;
-        auto size = ::recvfrom(fd, (char*)buffer.data(), bytes_available, 0, peer_->ai_addr, &len_);
+        auto size = ::recvfrom(fd, (char*)ptr, remaining_size, 0, peer_->ai_addr, &len_);
         if (size < 0) {
+            if (auto errno_ = errno; errno_ == EWOULDBLOCK || errno_ == EINTR) continue;
             return log_err(file, line, fd, Error(errno, ::strerror(errno)));
         }
 
+        ptr += size;
         remaining_size -= size;
 
-        if (remaining_size <= 0) {
+        if (remaining_size == 0) {
             return log_received_ok(file, line, fd, buffer);
         }
     }
-
-    return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_read_as_stream(const char*, int, int timeout, Descriptor* self, size_t n) -> Stream {
-    (void)timeout;
+auto delameta_detail_read_as_stream(const char* file, int line, int timeout_ms, Descriptor* self, size_t n, int fd) -> Stream {
     Stream s;
 
-    s << [self, total=n, buffer=std::vector<uint8_t>{}](Stream& s) mutable -> std::string_view {
+    s << [file, line, timeout_ms, self, fd, total=n, buffer=std::vector<uint8_t>{}, zero_copy=fd >= 0](Stream& s) mutable -> std::string_view {
+        // let the destination pull the bytes straight out of the socket, e.g. splice() into a file
+        if (zero_copy and s.sink) {
+            unsigned long bytes_available = 0;
+            auto [_, wait_err] = wait_readable(file, line, fd, Clock::now(), timeout_ms);
+            if (wait_err or IOCTL(fd, FIONREAD, &bytes_available) == -1 or bytes_available == 0) {
+                return {};
+            }
+
+            auto res = s.sink->write_from_fd(fd, std::min<size_t>(total, bytes_available));
+            if (res.is_ok() and res.unwrap() > 0) {
+                total -= std::min(total, res.unwrap());
+                s.again = total > 0;
+                return {};
+            }
+            zero_copy = false;
+        }
+
         size_t n = std::min(total, (size_t)MAX_HANDLE_SZ);
         auto data = self->read_until(n);
 
@@ -378,22 +591,18 @@ auto delameta_detail_read_as_stream(const char*, int, int timeout, Descriptor* s
     return s;
 }
 
-auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int), std::string_view data) -> Result<void> {
-    (void)timeout;
+auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout_ms, bool is_socket, std::string_view data) -> Result<void> {
+    auto start = Clock::now();
 #ifndef DELAMETA_DISABLE_OPENSSL
     auto ssl_ = reinterpret_cast<SSL*>(ssl);
 #endif
     size_t total = 0;
     for (size_t i = 0; i < data.size();) {
-        if (!is_alive(fd)) {
-            return log_err(file, line, fd, Error::ConnectionClosed);
-        }
-
         auto n = std::min<size_t>(MAX_HANDLE_SZ, data.size() - i);
 #ifndef DELAMETA_DISABLE_OPENSSL
-        auto sent = ssl ? SSL_write(ssl_, &data[i], n) : ::write(fd, &data[i], n);
+        ssize_t sent = ssl ? SSL_write(ssl_, &data[i], n) : is_socket ? ::send(fd, &data[i], n, MSG_NOSIGNAL) : ::write(fd, &data[i], n);
 #else
-        auto sent = ::write(fd, &data[i], n);
+        ssize_t sent = is_socket ? ::send(fd, &data[i], n, MSG_NOSIGNAL) : ::write(fd, &data[i], n);
 #endif
 
         if (sent == 0) {
@@ -408,9 +617,16 @@ auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]]
             }
 #endif
             auto errno_ = errno;
-            if (errno_ == EWOULDBLOCK || errno_ == EINPROGRESS) {
-                std::this_thread::sleep_for(10ms);
-                continue; // maybe try again
+            if (errno_ == EWOULDBLOCK || errno_ == EINPROGRESS || errno_ == EINTR) {
+                // send buffer is full, wait until the peer drains it
+                int res = delameta_detail_wait_fd(fd, POLLOUT, remaining_ms(start, timeout_ms));
+                if (res == 0) {
+                    return log_err(file, line, fd, Error::TransferTimeout);
+                }
+                continue; // try again
+            }
+            if (errno_ == EPIPE || errno_ == ECONNRESET) {
+                return log_err(file, line, fd, Error::ConnectionClosed);
             }
             return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
         }
@@ -422,14 +638,171 @@ auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]]
     return log_sent_ok(file, line, fd, total);
 }
 
-auto delameta_detail_sendto(const char* file, int line, int fd, int timeout, void* peer, std::string_view data) -> Result<void> {
-    (void)timeout;
+auto delameta_detail_writev(const char* file, int line, int fd, int timeout_ms, bool is_socket, const std::string_view* data, size_t n) -> Result<void> {
+    auto start = Clock::now();
     size_t total = 0;
-    for (size_t i = 0; i < data.size();) {
-        if (!delameta_detail_is_socket_alive(fd)) {
+    size_t offset = 0; // bytes of data[0] that are already written
+    struct iovec iov[IOV_MAX];
+
+    for (;;) {
+        while (n > 0 and offset == data->size()) {
+            ++data, --n;
+            offset = 0;
+        }
+        if (n == 0) break;
+
+        size_t cnt = std::min<size_t>(n, IOV_MAX);
+        for (size_t i = 0; i < cnt; ++i) {
+            size_t skip = i == 0 ? offset : 0;
+            iov[i].iov_base = const_cast<char*>(data[i].data() + skip);
+            iov[i].iov_len = data[i].size() - skip;
+        }
+
+        ssize_t sent;
+        if (is_socket) {
+            struct msghdr msg = {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        } else {
+            sent = ::writev(fd, iov, cnt);
+        }
+
+        if (sent == 0) {
             return log_err(file, line, fd, Error::ConnectionClosed);
+        } else if (sent < 0) {
+            auto errno_ = errno;
+            if (errno_ == EWOULDBLOCK || errno_ == EINPROGRESS || errno_ == EINTR) {
+                // send buffer is full, wait until the peer drains it
+                int res = delameta_detail_wait_fd(fd, POLLOUT, remaining_ms(start, timeout_ms));
+                if (res == 0) {
+                    return log_err(file, line, fd, Error::TransferTimeout);
+                }
+                continue; // try again
+            }
+            if (errno_ == EPIPE || errno_ == ECONNRESET) {
+                return log_err(file, line, fd, Error::ConnectionClosed);
+            }
+            return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+        }
+
+        total += sent;
+        for (size_t left = sent; left > 0;) {
+            auto step = std::min(left, data->size() - offset);
+            offset += step;
+            left -= step;
+            if (offset == data->size()) {
+                ++data, --n;
+                offset = 0;
+            }
         }
+    }
+
+    return log_sent_ok(file, line, fd, total);
+}
+
+auto delameta_detail_sendfile(const char* file, int line, int fd, int timeout_ms, int in_fd, size_t n, int64_t offset) -> Result<size_t> {
+    auto start = Clock::now();
+    size_t total = 0;
+    off_t pos = offset;
+
+    while (total < n) {
+        auto sent = ::sendfile(fd, in_fd, offset < 0 ? nullptr : &pos, n - total);
+        if (sent > 0) {
+            total += sent;
+            start = Clock::now();
+            continue;
+        } else if (sent == 0) {
+            break; // end of file
+        }
+
+        auto errno_ = errno;
+        if (errno_ == EWOULDBLOCK || errno_ == EINTR) {
+            // send buffer is full, wait until the peer drains it
+            if (delameta_detail_wait_fd(fd, POLLOUT, remaining_ms(start, timeout_ms)) == 0) {
+                return log_err(file, line, fd, Error::TransferTimeout);
+            }
+            continue;
+        }
+        return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "sent " + std::to_string(total) + " bytes of file"));
+    return Ok(total);
+}
+
+namespace {
+    // one splice() pipe per thread, it is dropped whenever it may still hold bytes
+    struct SplicePipe {
+        int fd[2] = {-1, -1};
+        size_t capacity = 0;
+
+        ~SplicePipe() { reset(); }
+
+        bool open() {
+            if (fd[0] >= 0) return true;
+            if (::pipe2(fd, O_CLOEXEC | O_NONBLOCK) < 0) return false;
+            auto sz = ::fcntl(fd[0], F_GETPIPE_SZ);
+            capacity = sz > 0 ? sz : 4096;
+            return true;
+        }
+
+        void reset() {
+            if (fd[0] < 0) return;
+            ::close(fd[0]);
+            ::close(fd[1]);
+            fd[0] = fd[1] = -1;
+        }
+    };
+
+    thread_local SplicePipe splice_pipe;
+}
+
+auto delameta_detail_splice(const char* file, int line, int fd, int in_fd, size_t n, int64_t offset) -> Result<size_t> {
+    if (::fcntl(fd, F_GETFL) & O_APPEND) {
+        return Err(Error{-1, "splice() into an append only file is not supported"});
+    }
+
+    auto& pipe = splice_pipe;
+    if (!pipe.open()) {
+        return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+    }
 
+    size_t total = 0;
+    while (total < n) {
+        // never ask for more than the pipe holds, a full pipe would otherwise stall the socket side
+        loff_t pos = offset + total;
+        auto in = ::splice(in_fd, offset < 0 ? nullptr : &pos, pipe.fd[1], nullptr, std::min(n - total, pipe.capacity), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (in == 0) {
+            break; // peer has closed the connection
+        } else if (in < 0) {
+            auto errno_ = errno;
+            if (errno_ == EINTR) continue;
+            if (errno_ == EWOULDBLOCK) break; // nothing else is buffered
+            return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+        }
+
+        for (auto left = in; left > 0;) {
+            auto out = ::splice(pipe.fd[0], nullptr, fd, nullptr, left, SPLICE_F_MOVE);
+            if (out < 0) {
+                auto errno_ = errno;
+                if (errno_ == EINTR) continue;
+                pipe.reset();
+                return log_err(file, line, fd, Error(errno_, ::strerror(errno_)));
+            }
+            left -= out;
+        }
+        total += in;
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "received " + std::to_string(total) + " bytes from socket"));
+    return Ok(total);
+}
+
+auto delameta_detail_sendto(const char* file, int line, int fd, int timeout_ms, void* peer, std::string_view data) -> Result<void> {
+    (void)timeout_ms;
+    size_t total = 0;
+    for (size_t i = 0; i < data.size();) {
         auto n = std::min<size_t>(MAX_HANDLE_SZ, data.size() - i);
         auto peer_ = reinterpret_cast<struct addrinfo *>(peer);
         auto sent = ::sendto(fd, &data[i], n, 0, peer_->ai_addr, peer_->ai_addrlen);
@@ -468,3 +841,203 @@ void delameta_detail_close_socket(int socket) {
     ::close(socket);
 }
 
+
+auto delameta_detail_listen(const LogError& log_error, const std::string& host, int backlog, int n) -> Result<std::vector<int>> {
+    auto [resolve, resolve_err] = delameta_detail_resolve_domain(host, SOCK_STREAM, true);
+    if (resolve_err) return Err(log_error(*resolve_err, ::gai_strerror));
+
+    auto hint = *resolve;
+    auto defer_hint = defer | [hint]() { ::freeaddrinfo(hint); };
+
+    std::vector<int> sockets;
+    auto fail = [&sockets](Error err) -> Result<std::vector<int>> {
+        for (auto socket : sockets) delameta_detail_close_socket(socket);
+        return Err(std::move(err));
+    };
+
+    sockets.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        auto [sock, sock_err] = delameta_detail_create_socket(hint, log_error);
+        if (sock_err) return fail(std::move(*sock_err));
+
+        auto socket = sockets.emplace_back(*sock);
+        if (int enable = 1; n > 1 and ::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0) {
+            return fail(log_error(errno, ::strerror));
+        }
+
+        if (::bind(socket, hint->ai_addr, hint->ai_addrlen) < 0) {
+            return fail(log_error(errno, ::strerror));
+        }
+
+        if (::listen(socket, backlog) < 0) {
+            return fail(log_error(errno, ::strerror));
+        }
+    }
+
+    return Ok(std::move(sockets));
+}
+
+void delameta_detail_pin_thread(int cpu) {
+    if (cpu < 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+    if (int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set); err != 0) {
+        WARNING("Unable to pin thread to cpu " + std::to_string(cpu) + ", " + ::strerror(err));
+    }
+}
+
+auto delameta_detail_run_shards(int n, const std::function<Result<void>(int)>& fn) -> Result<void> {
+    std::vector<std::optional<Error>> errors(n);
+    auto run = [&fn, &errors](int idx) {
+        auto [_, err] = fn(idx);
+        if (err) errors[idx] = std::move(*err);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (int i = 1; i < n; ++i) {
+        threads.emplace_back(run, i);
+    }
+    run(0);
+
+    for (auto& thd : threads) if (thd.joinable()) {
+        thd.join();
+    }
+
+    for (auto& err : errors) if (err) {
+        return Err(std::move(*err));
+    }
+    return Ok();
+}
+
+AcceptorPool::AcceptorPool(const char* file, int line, int socket, Args args)
+    : file(file)
+    , line(line)
+    , socket(socket)
+    , args(std::move(args))
+    , client_que(this->args.max_socket + this->args.max_pending) {}
+
+auto AcceptorPool::run(const std::atomic_bool& is_running, const Handler& handler) -> Result<void> {
+    LogError log_error{file, line};
+    delameta_detail_pin_thread(args.cpu);
+
+    auto epoll_fd = ::epoll_create1(0);
+    if (epoll_fd < 0) {
+        return Err(log_error(errno, ::strerror));
+    }
+
+    auto defer_epoll = defer | [epoll_fd]() { ::close(epoll_fd); };
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = socket;
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
+        return Err(log_error(errno, ::strerror));
+    }
+
+    // the clients inherit the ring of the worker that serves them. the acceptor may run on the caller's thread,
+    // so its ring is dropped again when the pool stops
+    const bool had_ring = delameta_detail_uring_active();
+    const bool io_uring = args.io_uring and delameta_detail_uring_enable(file, line);
+    auto defer_ring = defer | [io_uring, had_ring]() { if (io_uring and not had_ring) delameta_detail_uring_disable(); };
+
+    auto work = [this, &is_running, &handler, io_uring](int idx) {
+        delameta_detail_pin_thread(args.cpu);
+        if (io_uring) delameta_detail_uring_enable(file, line);
+        INFO_AT(file, line, "Spawned worker thread: " + std::to_string(idx));
+        while (is_running) {
+            int sock_client;
+            if (not client_que.pop(sock_client)) continue;
+
+            handler(sock_client, idx);
+            --n_client;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(args.max_socket);
+    for (int i = 0; i < args.max_socket; ++i) {
+        threads.emplace_back(work, i);
+    }
+
+    const int max_client = args.max_socket + args.max_pending;
+    const auto max_wait = std::chrono::milliseconds(args.max_pending_ms);
+
+    // wait up to 10ms for a new client, returns -1 if there is none
+    auto accept_client = [this, epoll_fd, io_uring]() -> int {
+        int new_sock_client = -1;
+        if (io_uring) {
+            new_sock_client = delameta_detail_uring_accept(socket, 10);
+        } else {
+            epoll_event event;
+            if (::epoll_wait(epoll_fd, &event, 1, 10) <= 0) return -1;
+
+            if (event.events & (EPOLLERR | EPOLLHUP)) {
+                WARNING("Epoll error or hang-up detected on fd: " + std::to_string(event.data.fd));
+                return -1;
+            }
+            new_sock_client = ::accept(socket, nullptr, nullptr);
+        }
+
+        if (new_sock_client < 0) {
+            if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINPROGRESS) {
+                WARNING(delameta_detail_log_format_fd(socket, "accept() failed, ") + strerror(errno_));
+            }
+        }
+        return new_sock_client;
+    };
+
+    while (is_running) {
+        int new_sock_client = accept_client();
+
+        // shed the clients that have been waiting for too long, oldest first
+        for (int sock_client; client_que.try_pop_pushed_before(sock_client, Clock::now() - max_wait);) {
+            WARNING(delameta_detail_log_format_fd(sock_client, "waited too long for a worker"));
+            shed(sock_client);
+            --n_client;
+        }
+
+        if (new_sock_client < 0) {
+            continue;
+        }
+
+        // only this thread increments `n_client`, so the queue always has room after this check
+        if (n_client >= max_client) {
+            WARNING(delameta_detail_log_format_fd(socket, "Thread pool is full"));
+            shed(new_sock_client);
+            continue;
+        }
+
+        ++n_client;
+        client_que.push(new_sock_client); // notify thread pool
+    }
+
+    wake();
+    for (auto& thd : threads) if (thd.joinable()) {
+        thd.join();
+    }
+
+    // clients that were still queued when the server stopped
+    for (int sock_client; client_que.try_pop(sock_client);) {
+        delameta_detail_close_socket(sock_client);
+    }
+    return Ok();
+}
+
+void AcceptorPool::wake() {
+    client_que.wake(args.max_socket);
+}
+
+void AcceptorPool::shed(int client) {
+    if (not args.overload_response.empty()) {
+        [[maybe_unused]] auto _ = ::send(client, args.overload_response.data(), args.overload_response.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+
+    // drain what the client has sent so far, closing with unread data would reset the connection
+    ::shutdown(client, SHUT_WR);
+    char buf[512];
+    for (int i = 0; i < 16 and ::recv(client, buf, sizeof(buf), MSG_DONTWAIT) > 0; ++i) {}
+    ::close(client);
+}
@@ -3,14 +3,25 @@
 
 #include "delameta/debug.h"
 #include "delameta/stream.h"
+#include "delameta/tcp.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <cerrno>
+#include <semaphore.h>
 
 int delameta_detail_set_non_blocking(int socket);
 int delameta_detail_set_blocking(int socket);
 bool delameta_detail_is_fd_alive(int fd);
-bool delameta_detail_is_socket_alive(int socket);
 auto delameta_detail_get_ip(int socket) -> std::string;
 auto delameta_detail_get_filename(int fd) -> std::string;
 
+// poll a single fd for `events`. returns >0 if ready, 0 on timeout, -1 on error
+int delameta_detail_wait_fd(int fd, short events, int timeout_ms);
+
 auto delameta_detail_log_format_fd(
     int fd,
     const std::string& msg
@@ -25,45 +36,148 @@ auto delameta_detail_resolve_domain(
 auto delameta_detail_read(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
-    bool(*is_alive)(int)
+    int timeout_ms
+) -> Project::delameta::Result<std::vector<uint8_t>>;
+
+// same as delameta_detail_read but into a pooled buffer
+auto delameta_detail_read_buffer(
+    const char* file, int line, 
+    int fd, void* ssl,
+    int timeout_ms
+) -> Project::delameta::Result<Project::delameta::Buffer>;
+
+// read what is available, at most `cap` bytes, into `buf`. a default `deadline` means `timeout_ms` from now
+auto delameta_detail_read_into(
+    const char* file, int line, 
+    int fd, void* ssl,
+    int timeout_ms, Project::delameta::Deadline deadline, 
+    uint8_t* buf, size_t cap
+) -> Project::delameta::Result<size_t>;
+
+// read one frame, it ends once the line has been silent for `gap_us`. on a line that doesn't go silent it is cut at
+// `max_size` bytes or when the timeout expires, whatever comes first
+auto delameta_detail_read_frame(
+    const char* file, int line, 
+    int fd, int timeout_ms, 
+    int gap_us, size_t max_size
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
+// same as delameta_detail_read_frame but into `buf`, a frame longer than `cap` is split
+auto delameta_detail_read_frame_into(
+    const char* file, int line, 
+    int fd, int timeout_ms, Project::delameta::Deadline deadline, 
+    int gap_us, uint8_t* buf, size_t cap
+) -> Project::delameta::Result<size_t>;
+
 auto delameta_detail_recvfrom(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void *peer
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
+// receive one datagram into `buf`, the part of it beyond `cap` bytes is discarded
+auto delameta_detail_recvfrom_into(
+    const char* file, int line, 
+    int fd, int timeout_ms, Project::delameta::Deadline deadline, 
+    void *peer, uint8_t* buf, size_t cap
+) -> Project::delameta::Result<size_t>;
+
 auto delameta_detail_read_until(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
-    bool(*is_alive)(int), size_t n
+    int timeout_ms, 
+    size_t n
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
 auto delameta_detail_recvfrom_until(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void *peer, size_t n
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
+// `fd` is the underlying socket of `self`, when given the stream may hand it to its sink's write_from_fd()
 auto delameta_detail_read_as_stream(
     const char* file, int line, 
-    int timeout, 
-    Project::delameta::Descriptor* self, size_t n
+    int timeout_ms, 
+    Project::delameta::Descriptor* self, size_t n,
+    int fd = -1
 ) -> Project::delameta::Stream;
 
+// a socket is written with MSG_NOSIGNAL, so a peer that is gone shows up as ConnectionClosed instead of SIGPIPE
 auto delameta_detail_write(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
-    bool(*is_alive)(int), std::string_view data
+    int timeout_ms, 
+    bool is_socket, std::string_view data
+) -> Project::delameta::Result<void>;
+
+// gather write of the `n` pieces of `data` with writev(), not usable with TLS
+auto delameta_detail_writev(
+    const char* file, int line, 
+    int fd, int timeout_ms, 
+    bool is_socket, const std::string_view* data, size_t n
+) -> Project::delameta::Result<void>;
+
+// sendfile() up to `n` bytes of `in_fd` into the socket `fd`, `timeout_ms` applies to each stall.
+// reads from `offset` without moving the position of `in_fd` unless it is negative
+auto delameta_detail_sendfile(
+    const char* file, int line, 
+    int fd, int timeout_ms, 
+    int in_fd, size_t n, int64_t offset = -1
+) -> Project::delameta::Result<size_t>;
+
+// splice() up to `n` bytes from the socket `in_fd` into the file `fd` through a pipe. only moves what is already
+// buffered in the socket, returns the number of bytes moved
+auto delameta_detail_splice(
+    const char* file, int line, 
+    int fd, int in_fd, size_t n, int64_t offset = -1
+) -> Project::delameta::Result<size_t>;
+
+// io_uring backend, compiled in with DELAMETA_ENABLE_IO_URING. a thread that enables it gets its own ring, the TCP
+// sockets used on that thread then submit their reads, writes and sendfile through the ring
+bool delameta_detail_uring_enable(const char* file, int line);
+void delameta_detail_uring_disable();
+bool delameta_detail_uring_active();
+
+auto delameta_detail_uring_read(
+    const char* file, int line, 
+    int fd, int timeout_ms
+) -> Project::delameta::Result<std::vector<uint8_t>>;
+
+auto delameta_detail_uring_read_buffer(
+    const char* file, int line, 
+    int fd, int timeout_ms
+) -> Project::delameta::Result<Project::delameta::Buffer>;
+
+auto delameta_detail_uring_read_into(
+    const char* file, int line, 
+    int fd, int timeout_ms, Project::delameta::Deadline deadline, 
+    uint8_t* buf, size_t cap
+) -> Project::delameta::Result<size_t>;
+
+auto delameta_detail_uring_read_until(
+    const char* file, int line, 
+    int fd, int timeout_ms, size_t n
+) -> Project::delameta::Result<std::vector<uint8_t>>;
+
+auto delameta_detail_uring_write(
+    const char* file, int line, 
+    int fd, int timeout_ms, 
+    std::string_view data
 ) -> Project::delameta::Result<void>;
 
+auto delameta_detail_uring_sendfile(
+    const char* file, int line, 
+    int fd, int timeout_ms, 
+    int in_fd, size_t n, int64_t offset = -1
+) -> Project::delameta::Result<size_t>;
+
+// accept one client, waiting at most `timeout_ms`. returns -1 and sets errno on failure or timeout
+int delameta_detail_uring_accept(int socket, int timeout_ms);
+
 auto delameta_detail_sendto(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void* peer, std::string_view data
 ) -> Project::delameta::Result<void>;
 
@@ -76,7 +190,7 @@ namespace Project::delameta {
         template <typename F>
         Error operator()(int code, F err_to_str) const {
             std::string what = err_to_str(code);
-            warning(file, line, what);
+            WARNING_AT(file, line, what);
             return Error{code, std::move(what)};
         }
     };
@@ -85,4 +199,182 @@ namespace Project::delameta {
 auto delameta_detail_create_socket(void* hint, const Project::delameta::LogError& log_error) -> Project::delameta::Result<int>;
 void delameta_detail_close_socket(int socket);
 
+// bind and listen `n` sockets on the same address, they share the port with SO_REUSEPORT when n > 1
+auto delameta_detail_listen(
+    const Project::delameta::LogError& log_error,
+    const std::string& host,
+    int backlog, int n
+) -> Project::delameta::Result<std::vector<int>>;
+
+// pin the calling thread to `cpu` modulo the number of cores, negative means no pinning
+void delameta_detail_pin_thread(int cpu);
+
+// run `fn(i)` for every shard in [0, n) concurrently, shard 0 runs on the calling thread.
+// returns the first error of any shard
+auto delameta_detail_run_shards(
+    int n, 
+    const std::function<Project::delameta::Result<void>(int)>& fn
+) -> Project::delameta::Result<void>;
+
+namespace Project::delameta {
+
+    // Bounded lock-free MPMC ring (Vyukov). Consumers block on a semaphore that is posted after every push,
+    // so an item can never be left behind by a worker that was busy when it was pushed
+    template <typename T>
+    class HandoffQueue {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit HandoffQueue(size_t capacity) {
+            size_t n = 2;
+            while (n < capacity) n <<= 1;
+            cells.reset(new Cell[n]);
+            mask = n - 1;
+            for (size_t i = 0; i < n; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+            ::sem_init(&sem, 0, 0);
+        }
+
+        ~HandoffQueue() { ::sem_destroy(&sem); }
+
+        HandoffQueue(const HandoffQueue&) = delete;
+        HandoffQueue& operator=(const HandoffQueue&) = delete;
+
+        // returns false if the queue is full
+        bool push(T item) {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &cells[pos & mask];
+                auto diff = intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos);
+                if (diff == 0 and tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                if (diff < 0) return false;
+                if (diff > 0) pos = tail.load(std::memory_order_relaxed);
+            }
+
+            cell->item = std::move(item);
+            cell->pushed.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            cell->seq.store(pos + 1, std::memory_order_release);
+            depth_.fetch_add(1, std::memory_order_relaxed);
+            ::sem_post(&sem);
+            return true;
+        }
+
+        // non-blocking, returns false if there is no item ready
+        bool try_pop(T& item) {
+            return try_pop_pushed_before(item, Clock::time_point::max());
+        }
+
+        // non-blocking, pops the oldest item only if it was pushed before `t`
+        bool try_pop_pushed_before(T& item, Clock::time_point t) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &cells[pos & mask];
+                auto diff = intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos + 1);
+                if (diff == 0 and cell->pushed.load(std::memory_order_relaxed) >= t.time_since_epoch().count()) return false;
+                if (diff == 0 and head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                if (diff < 0) return false;
+                if (diff > 0) pos = head.load(std::memory_order_relaxed);
+            }
+
+            item = std::move(cell->item);
+            auto waited = Clock::now().time_since_epoch() - Clock::duration(cell->pushed.load(std::memory_order_relaxed));
+            auto wait_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+            cell->seq.store(pos + mask + 1, std::memory_order_release);
+            depth_.fetch_sub(1, std::memory_order_relaxed);
+
+            handoffs_.fetch_add(1, std::memory_order_relaxed);
+            wait_ns_total_.fetch_add(wait_ns, std::memory_order_relaxed);
+            for (auto max = wait_ns_max_.load(std::memory_order_relaxed); wait_ns > max;) {
+                if (wait_ns_max_.compare_exchange_weak(max, wait_ns, std::memory_order_relaxed)) break;
+            }
+            return true;
+        }
+
+        // blocks until an item is popped or `wake` is called, returns false in the latter case
+        bool pop(T& item) {
+            while (::sem_wait(&sem) < 0 and errno == EINTR) {}
+            while (not try_pop(item)) {
+                // a producer may have claimed a cell without publishing it yet
+                if (depth_.load(std::memory_order_acquire) == 0) return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        // release up to `n` blocked consumers
+        void wake(int n) {
+            for (int i = 0; i < n; ++i) ::sem_post(&sem);
+        }
+
+        size_t depth() const { return depth_.load(std::memory_order_relaxed); }
+        uint64_t handoffs() const { return handoffs_.load(std::memory_order_relaxed); }
+        uint64_t wait_ns_total() const { return wait_ns_total_.load(std::memory_order_relaxed); }
+        uint64_t wait_ns_max() const { return wait_ns_max_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> seq;
+            T item;
+            std::atomic<Clock::rep> pushed; // atomic, it is peeked before the cell is claimed
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head {0};
+        alignas(64) std::atomic<size_t> tail {0};
+        sem_t sem;
+
+        std::atomic<size_t> depth_ {0};
+        std::atomic<uint64_t> handoffs_ {0};
+        std::atomic<uint64_t> wait_ns_total_ {0};
+        std::atomic<uint64_t> wait_ns_max_ {0};
+    };
+
+    // Accepts the clients of one listen socket and serves each of them on one of `max_socket` worker threads.
+    // Server<TCP> and Server<TLS> run one pool per listen socket
+    class AcceptorPool {
+    public:
+        // serves `client` until it is done with it, the client socket is owned by the handler
+        using Handler = std::function<void(int client, int worker_idx)>;
+
+        struct Args {
+            int max_socket;
+            int max_pending = 0; // clients that may wait for a free worker
+            int max_pending_ms = 1000; // how long a client may wait before it is shed
+            std::string overload_response = ""; // written to a shed client before closing it
+            int cpu = -1;
+            bool io_uring = false; // accept and serve the clients through a per thread io_uring
+        };
+
+        AcceptorPool(const char* file, int line, int socket, Args args);
+
+        // spawn the workers and accept clients until `is_running` is cleared
+        Result<void> run(const std::atomic_bool& is_running, const Handler& handler);
+        void wake();
+
+        const HandoffQueue<int>& queue() const { return client_que; }
+
+    private:
+        const char* file;
+        int line;
+        int socket;
+        Args args;
+
+        // answer a client that cannot be served with `overload_response` and close it
+        void shed(int client);
+
+        std::atomic<int> n_client {0}; // queued or being served
+        HandoffQueue<int> client_que;
+    };
+
+    template <typename T>
+    void delameta_detail_add_queue_stats(ServerQueueStats& stats, const HandoffQueue<T>& que) {
+        stats.depth += que.depth();
+        stats.handoffs += que.handoffs();
+        stats.wait_ns_total += que.wait_ns_total();
+        stats.wait_ns_max = std::max<uint64_t>(stats.wait_ns_max, que.wait_ns_max());
+    }
+}
+
 #endif
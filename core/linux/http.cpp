@@ -1,7 +1,11 @@
 #include "delameta/http/http.h"
 #include "delameta/file.h"
 #include "delameta/utils.h"
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <list>
+#include <mutex>
 
 using namespace Project;
 using etl::Ok;
@@ -11,41 +15,200 @@ using delameta::File;
 namespace fs = std::filesystem;
 namespace http = delameta::http;
 
-static auto get_file(const std::string& filename, Ref<http::ResponseWriter> res, bool chunked) -> http::Result<void> {
-    return File::Open(File::Args{.filename=filename, .mode="r"}).then([&](File file) {
-        res->headers["Content-Type"] = delameta::get_content_type_from_file(filename);
-        if (not chunked) {
-            res->headers["Content-Lenght"] = std::to_string(file.file_size());
+namespace {
+    struct CachedFile {
+        std::string filename;
+        std::string_view content_type;
+        std::shared_ptr<File> file;
+        File::Stat stat;
+        mutable std::atomic<int64_t> checked_ms; // when `stat` was last compared with the file at `filename`
+    };
+
+    // bounded LRU of open files keyed by the normalized request path, shared by the requests of one Static() call.
+    // only hits are kept, so a new file is found on its first request
+    class StaticCache {
+    public:
+        explicit StaticCache(size_t capacity) : capacity(capacity) {}
+
+        std::shared_ptr<const CachedFile> get(const std::string& key) {
+            if (capacity == 0) return nullptr;
+            std::lock_guard lock(mutex);
+            auto it = index.find(key);
+            if (it == index.end()) return nullptr;
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
         }
-        file >> res->body_stream;
-    });
-}
 
-auto http::Http::Static(const std::string& prefix, const std::string& root, bool chunked) -> delameta::Result<void> {
-    fs::path dir = root;
+        void put(const std::string& key, std::shared_ptr<const CachedFile> entry) {
+            if (capacity == 0) return;
+            std::lock_guard lock(mutex);
+            if (index.count(key) > 0) return;
+            if (entries.size() >= capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+            entries.emplace_front(key, std::move(entry));
+            index.emplace(entries.front().first, entries.begin());
+        }
+
+        // only if `key` still holds `entry`, another request may have put a newer one already
+        void erase(const std::string& key, const CachedFile* entry) {
+            if (capacity == 0) return;
+            std::lock_guard lock(mutex);
+            auto it = index.find(key);
+            if (it == index.end() or it->second->second.get() != entry) return;
+            entries.erase(it->second);
+            index.erase(it);
+        }
+
+    private:
+        using Entries = std::list<std::pair<std::string, std::shared_ptr<const CachedFile>>>;
+
+        size_t capacity;
+        std::mutex mutex;
+        Entries entries; // most recently used first
+        std::unordered_map<std::string_view, Entries::iterator> index; // keys point into `entries`
+    };
+
+    int64_t now_ms() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    }
+
+    struct StaticMount {
+        fs::path root;
+        std::string index;
+        bool chunked;
+        int revalidate_ms;
+        std::shared_ptr<StaticCache> cache; // shared with the responses, they drop an entry whose file got shorter
+
+        auto open(const std::string& key) const -> std::shared_ptr<const CachedFile> {
+            fs::path rel = key;
+            if (rel.has_root_name() or rel.has_root_directory()) return nullptr;
+
+            std::error_code ec;
+            fs::path path = key.empty() ? root : root / rel;
+            if (fs::is_directory(path, ec)) path /= index;
+            if (not fs::is_regular_file(path, ec)) return nullptr;
+
+            auto filename = path.string();
+            auto file = File::Open(File::Args{.filename=filename, .mode="r"});
+            if (file.is_err()) return nullptr;
+
+            auto stat = file.unwrap().stat();
+            if (stat.is_err()) return nullptr;
 
-    if (not fs::is_directory(dir)) {
+            auto content_type = delameta::get_content_type_from_file(filename);
+            return std::shared_ptr<const CachedFile>(new CachedFile{
+                .filename=std::move(filename),
+                .content_type=content_type,
+                .file=std::make_shared<File>(std::move(file.unwrap())),
+                .stat=stat.unwrap(),
+                .checked_ms=now_ms(),
+            });
+        }
+
+        // whether the file at the path of `entry` is still the one it holds open
+        bool is_fresh(const CachedFile& entry) const {
+            auto now = now_ms();
+            if (now - entry.checked_ms.load(std::memory_order_relaxed) < revalidate_ms) return true;
+
+            auto stat = File::stat(entry.filename);
+            if (stat.is_err() or stat.unwrap() != entry.stat) return false;
+
+            entry.checked_ms.store(now, std::memory_order_relaxed);
+            return true;
+        }
+
+        auto serve_key(const std::string& key, Ref<http::ResponseWriter> res) -> http::Result<void> {
+            auto entry = cache->get(key);
+            if (entry and not is_fresh(*entry)) {
+                cache->erase(key, entry.get());
+                entry = nullptr;
+            }
+
+            if (entry == nullptr) {
+                entry = open(key);
+                if (entry == nullptr) return Err(http::Error{http::StatusNotFound});
+                cache->put(key, entry);
+            }
+
+            res->headers["Content-Type"] = entry->content_type;
+            if (not chunked) {
+                res->headers["Content-Length"] = std::to_string(entry->stat.size);
+            }
+            File::stream_at(entry->file, res->body_stream, 0, entry->stat.size, [cache=cache, key, entry]() {
+                cache->erase(key, entry.get());
+            });
+            return Ok();
+        }
+
+        auto serve(std::string_view path, Ref<http::ResponseWriter> res) -> http::Result<void> {
+            auto key = http::normalize_path(path);
+            if (key.is_err()) return Err(std::move(key.unwrap_err()));
+            return serve_key(key.unwrap(), res);
+        }
+    };
+}
+
+auto http::Http::Static(const std::string& prefix, const std::string& root, StaticArgs args) -> delameta::Result<void> {
+    if (not fs::is_directory(root)) {
         return Err(Error{-1, root + " is not a directory"});
     }
 
-    dir = fs::absolute(dir);
-    for (const auto& entry: fs::recursive_directory_iterator(dir)) {
-        fs::path abs_file = entry.path();
-        fs::path rel_file = fs::relative(abs_file, dir);
-        std::string route_name = prefix + rel_file.string();
+    auto mount = std::shared_ptr<StaticMount>(new StaticMount{
+        .root=fs::absolute(root),
+        .index=args.index,
+        .chunked=args.chunked,
+        .revalidate_ms=args.revalidate_ms,
+        .cache=std::make_shared<StaticCache>(args.cache_size),
+    });
 
-        this->Get(route_name).args(http::arg::response)|
-        [filename=abs_file.string(), chunked](Ref<ResponseWriter> res) {
-            return get_file(filename, res, chunked);
-        };
+    if (not args.mount) {
+        for (const auto& entry: fs::recursive_directory_iterator(mount->root)) {
+            auto key = fs::relative(entry.path(), mount->root).generic_string();
+
+            // the route is a pattern, a brace in a file name would make it a parameter or an invalid pattern
+            if (key.find_first_of("{}") != std::string::npos) {
+                WARNING("Static: skipped " + entry.path().string() + ", braces can't be routed, use the mount mode");
+                continue;
+            }
 
-        if (route_name == "/index.html") {
-            this->Get(prefix).args(http::arg::request, http::arg::response)|
-            [this](Ref<const http::RequestReader> req, Ref<http::ResponseWriter> res) {
-                return this->reroute("/index.html", req, res);
+            std::string route_name = prefix + key;
+
+            this->Get(route_name).args(http::arg::response)|
+            [mount, key](Ref<ResponseWriter> res) {
+                return mount->serve_key(key, res);
             };
+
+            if (route_name == "/index.html") {
+                this->Get(prefix).args(http::arg::request, http::arg::response)|
+                [this](Ref<const http::RequestReader> req, Ref<http::ResponseWriter> res) {
+                    return this->reroute("/index.html", req, res);
+                };
+            }
         }
+        return Ok();
+    }
+
+    auto base = prefix;
+    while (not base.empty() and base.back() == '/') base.pop_back();
+
+    this->Get(base + "/{path*}").args(http::arg::request, http::arg::response)|
+    [mount](Ref<const http::RequestReader> req, Ref<http::ResponseWriter> res) {
+        return mount->serve(*req->path_param("path"), res);
+    };
+
+    if (not base.empty()) {
+        this->Get(base).args(http::arg::response)|
+        [mount](Ref<http::ResponseWriter> res) {
+            return mount->serve("", res);
+        };
     }
 
     return Ok();
 }
+
+auto http::Http::Static(const std::string& prefix, const std::string& root, bool chunked) -> delameta::Result<void> {
+    return Static(prefix, root, StaticArgs{.chunked=chunked});
+}
@@ -1,17 +1,18 @@
 #include "delameta/tcp.h"
+#include "delameta/http/parser.h"
+#include "delameta/utils.h"
 #include "helper.h"
 #include <cerrno>
 #include <cstring>
-#include <unordered_set>
-#include <deque>
+#include <unordered_map>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
 
 // Unix/Linux headers and definitions
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -47,7 +48,7 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
         }
 
         ::inet_ntop(hint->ai_family, addr, ip_str, sizeof ip_str);
-        info(__FILE__, __LINE__, "resolved: " + std::string(ip_str));
+        INFO_AT(__FILE__, __LINE__, "resolved: " + std::string(ip_str));
     }
 
     for (auto p = hint; p != nullptr; p = p->ai_next) {
@@ -90,24 +91,25 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
             }
         }
 
-        return Ok(TCP(file, line, socket, args.timeout));
+        return Ok(TCP(file, line, socket, timeout_ms_of(args.timeout, args.timeout_ms)));
     }
 
     return Err(std::move(err));
 }
 
-TCP::TCP(const char* file, int line, int socket, int timeout)
+TCP::TCP(const char* file, int line, int socket, int timeout_ms)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
     , keep_alive(true)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , max(-1) 
     , file(file)
     , line(line)
 {
+    request_timeout_ms = timeout_ms;
     delameta_detail_set_non_blocking(socket);
-    info(file, line, delameta_detail_log_format_fd(socket, "created"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(socket, "created"));
 }
 
 TCP::TCP(TCP&& other)
@@ -115,186 +117,541 @@ TCP::TCP(TCP&& other)
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
     , keep_alive(other.keep_alive)
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , max(other.max) 
     , file(other.file)
-    , line(other.line) {}
+    , line(other.line) { request_timeout_ms = other.request_timeout_ms; }
 
 TCP::~TCP() {
     if (socket >= 0) {
-        info(file, line, delameta_detail_log_format_fd(socket, "closed"));
+        INFO_AT(file, line, delameta_detail_log_format_fd(socket, "closed"));
         delameta_detail_close_socket(socket);
         socket = -1;
     }
 }
 
 auto TCP::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive);
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_read(file, line, socket, timeout_left(timeout_ms, deadline));
+    }
+    return delameta_detail_read(file, line, socket, nullptr, timeout_left(timeout_ms, deadline));
 }
 
 auto TCP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read_until(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive, n);
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_read_until(file, line, socket, timeout_left(timeout_ms, deadline), n);
+    }
+    return delameta_detail_read_until(file, line, socket, nullptr, timeout_left(timeout_ms, deadline), n);
+}
+
+auto TCP::read_buffer() -> Result<Buffer> {
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_read_buffer(file, line, socket, timeout_left(timeout_ms, deadline));
+    }
+    return delameta_detail_read_buffer(file, line, socket, nullptr, timeout_left(timeout_ms, deadline));
+}
+
+auto TCP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_read_into(file, line, socket, timeout_left(timeout_ms, Descriptor::deadline), deadline, buf, cap);
+    }
+    return delameta_detail_read_into(file, line, socket, nullptr, timeout_left(timeout_ms, Descriptor::deadline), deadline, buf, cap);
 }
 
 auto TCP::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n, socket);
 }
 
 auto TCP::write(std::string_view data) -> Result<void> {
-    return delameta_detail_write(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive, data);
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_write(file, line, socket, timeout_left(timeout_ms, deadline), data);
+    }
+    return delameta_detail_write(file, line, socket, nullptr, timeout_left(timeout_ms, deadline), true, data);
+}
+
+auto TCP::writev(const std::string_view* data, size_t n) -> Result<void> {
+    if (delameta_detail_uring_active()) {
+        return Descriptor::writev(data, n);
+    }
+    return delameta_detail_writev(file, line, socket, timeout_left(timeout_ms, deadline), true, data, n);
+}
+
+auto TCP::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    if (delameta_detail_uring_active()) {
+        return delameta_detail_uring_sendfile(file, line, socket, timeout_left(timeout_ms, deadline), fd, n, offset);
+    }
+    return delameta_detail_sendfile(file, line, socket, timeout_left(timeout_ms, deadline), fd, n, offset);
 }
 
 auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
     if (args.max_socket <= 0) {
         return Err("Invalid max socket value, must be positive integer");
     }
+    if (args.n_shard <= 0) {
+        return Err("Invalid shard value, must be positive integer");
+    }
+    if (args.max_pending < 0) {
+        return Err("Invalid max pending value, must be non-negative integer");
+    }
 
     LogError log_error{file, line};
-    auto [resolve, resolve_err] = delameta_detail_resolve_domain(args.host, SOCK_STREAM, true);
-    if (resolve_err) return Err(log_error(*resolve_err, ::gai_strerror));
-
-    auto hint = *resolve;
-    auto defer_hint = defer | [hint]() { ::freeaddrinfo(hint); };
+    auto [listen, listen_err] = delameta_detail_listen(log_error, args.host, args.event_loop ? SOMAXCONN : args.max_socket + args.max_pending, args.n_shard);
+    if (listen_err) return Err(std::move(*listen_err));
 
-    auto [sock, sock_err] = delameta_detail_create_socket(hint, log_error);
-    if (sock_err) return Err(std::move(*sock_err));
+    auto sockets = std::move(*listen);
+    auto defer_sockets = defer | [&sockets]() { for (auto socket : sockets) delameta_detail_close_socket(socket); };
 
-    auto socket = *sock;
-    auto defer_socket = defer | [socket]() { delameta_detail_close_socket(socket); };
-
-    if (::bind(socket, hint->ai_addr, hint->ai_addrlen) < 0) {
-        return Err(log_error(errno, ::strerror));
+    if (args.event_loop) {
+        return start_event_loop(file, line, args, sockets);
     }
 
-    if (::listen(socket, args.max_socket) < 0) {
-        return Err(log_error(errno, ::strerror));
+    std::vector<std::unique_ptr<AcceptorPool>> pools;
+    pools.reserve(sockets.size());
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        pools.push_back(std::make_unique<AcceptorPool>(file, line, sockets[i], AcceptorPool::Args{
+            .max_socket=args.max_socket,
+            .max_pending=args.max_pending,
+            .max_pending_ms=args.max_pending_ms,
+            .overload_response=args.overload_response,
+            .cpu=args.pin_cpu ? int(i) : -1,
+            .io_uring=args.io_uring,
+        }));
     }
 
-    auto epoll_fd = ::epoll_create1(0);
-    if (epoll_fd < 0) {
-        return Err(log_error(errno, ::strerror));
-    }
+    std::atomic_bool is_running {true};
+
+    on_stop = [this, &is_running, &pools]() {
+        is_running = false;
+        for (auto& pool : pools) pool->wake();
+        on_queue_stats = {};
+        on_stop = {};
+    };
+
+    on_queue_stats = [&pools]() {
+        ServerQueueStats stats;
+        for (auto& pool : pools) delameta_detail_add_queue_stats(stats, pool->queue());
+        return stats;
+    };
+
+    auto serve = [this, file, line, &args, &is_running](int sock_client, int idx) {
+        INFO_AT(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
+
+        TCP session(file, line, sock_client, timeout_ms_of(args.timeout, args.timeout_ms));
+        session.keep_alive = args.keep_alive;
+        std::vector<uint8_t> data; // reused by every request of this connection
+        auto ip = delameta_detail_get_ip(sock_client);
+        bool closed_by_peer = false;
+
+        for (int cnt = 1; is_running; ++cnt) {
+            auto received_result = session.read_buffer(); // TODO: read() doesn't check for `is_running`
+            if (received_result.is_err()) {
+                closed_by_peer = received_result.unwrap_err().code == Error::ConnectionClosed;
+                break;
+            }
+
+            auto& received = received_result.unwrap();
+            data.assign(received.begin(), received.end());
+
+            // the rest of the request and the response share one deadline
+            DeadlineScope scope(session, session.timeout_ms);
+            auto stream = this->execute_stream_session(session, ip, data);
+            stream >> session;
+
+            if (not session.keep_alive) {
+                if (session.max > 0 and cnt >= session.max) {
+                    INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
+                }
+                break;
+            }
+
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
+        }
+
+        // shutdown if still connected
+        if (not closed_by_peer) {
+            ::shutdown(session.socket, SHUT_RDWR);
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
+        } else {
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
+        }
+    };
+
+    return delameta_detail_run_shards(pools.size(), [this, &pools, &is_running, &serve](int idx) {
+        auto res = pools[idx]->run(is_running, serve);
+        if (res.is_err()) stop();
+        return res;
+    });
+}
+
+namespace {
+    // a Content-Length body up to this size is read by the event loop together with the head, a bigger one is
+    // streamed by the worker
+    constexpr size_t event_loop_max_body = 64 * 1024;
+
+    struct EventLoopConnection {
+        std::unique_ptr<TCP> session;
+        std::vector<uint8_t> data; // request bytes, reused by every request of this connection
+        std::string ip; // of the peer, resolved once when accepted
+        std::chrono::steady_clock::time_point last_active;
+        bool busy = false; // owned by a worker, the loop must not touch it
+        http::HeadParser parser; // of the request the loop is buffering in `data`
+        size_t request_size = 0; // the head and the body the loop waits for, known once the head is complete
+
+        // append what the peer has sent so far without blocking, returns false once it has closed the connection
+        bool receive() {
+            char buf[16 * 1024];
+            size_t limit = data.size() + http::HeadLimits{}.max_head_size + event_loop_max_body;
+            while (data.size() < limit) {
+                auto n = ::recv(session->socket, buf, sizeof(buf), MSG_DONTWAIT);
+                if (n > 0) {
+                    data.insert(data.end(), buf, buf + n);
+                } else if (n < 0 and errno == EINTR) {
+                    continue;
+                } else {
+                    return n < 0 and (errno == EAGAIN or errno == EWOULDBLOCK);
+                }
+            }
+            return true;
+        }
+
+        // whether `data` holds the whole head and the Content-Length body, if any, so a worker can serve it without
+        // waiting for the peer. a head the parser rejects is ready too, the worker answers it
+        bool request_ready() {
+            auto sv = string_view_from(data);
+            if (request_size == 0) {
+                auto state = parser.feed(sv);
+                if (state == http::HeadParser::Partial) return false;
+                if (state != http::HeadParser::Complete) return true;
+                request_size = parser.head_size() + body_size(sv.substr(0, parser.head_size()));
+            }
+            return data.size() >= request_size;
+        }
+
+        // forget the served request, the next one starts from scratch
+        void reset() {
+            data.clear();
+            parser = http::HeadParser();
+            request_size = 0;
+        }
+
+    private:
+        // the body length to wait for, 0 if it is chunked or too big for the loop to hold
+        static size_t body_size(std::string_view head) {
+            size_t content_length = 0;
+            string_view_consume_line(head);
+            while (not head.empty()) {
+                auto line = string_view_consume_line(head);
+                auto key = line.substr(0, line.find(':'));
+                if (key == "Transfer-Encoding" or key == "transfer-encoding") return 0;
+                if (key.size() == line.size() or not (key == "Content-Length" or key == "content-length")) continue;
+
+                auto value = line.substr(key.size() + 1);
+                while (not value.empty() and (value.front() == ' ' or value.front() == '\t')) value.remove_prefix(1);
+                while (not value.empty() and (value.back() == ' ' or value.back() == '\t')) value.remove_suffix(1);
+                content_length = string_num_into<size_t>(value).unwrap_or(0);
+            }
+            return content_length <= event_loop_max_body ? content_length : 0;
+        }
+    };
+
+    struct EventLoop {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        std::mutex mtx;
+        std::unordered_map<int, EventLoopConnection> connections;
+
+        ~EventLoop() {
+            if (wake_fd >= 0) ::close(wake_fd);
+            if (epoll_fd >= 0) ::close(epoll_fd);
+        }
+
+        bool arm(int fd, int op) {
+            epoll_event event;
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            event.data.fd = fd;
+            return ::epoll_ctl(epoll_fd, op, fd, &event) == 0;
+        }
 
-    auto defer_epoll = defer | [epoll_fd]() { ::close(epoll_fd); };
+        void wake() {
+            uint64_t one = 1;
+            [[maybe_unused]] auto _ = ::write(wake_fd, &one, sizeof(one));
+        }
+    };
+
+    // the acceptor, event loops and workers of one listen socket
+    struct EventLoopShard {
+        using Task = std::pair<EventLoop*, EventLoopConnection*>;
+
+        int socket = -1;
+        int epoll_fd = -1;
+        int n_workers;
+        std::vector<std::unique_ptr<EventLoop>> loops;
+        HandoffQueue<Task> task_que;
+
+        EventLoopShard(int n_workers, size_t capacity) : n_workers(n_workers), task_que(capacity) {}
+
+        ~EventLoopShard() {
+            if (epoll_fd >= 0) ::close(epoll_fd);
+        }
+
+        void wake() {
+            task_que.wake(n_workers);
+            for (auto& loop : loops) loop->wake();
+        }
+    };
+}
+
+auto Server<TCP>::start_event_loop(const char* file, int line, const Args& args, const std::vector<int>& sockets) -> Result<void> {
+    LogError log_error{file, line};
+    using Clock = std::chrono::steady_clock;
+    using Task = EventLoopShard::Task;
+
+    int n_shard = sockets.size();
+    int n_loops = args.n_event_loop > 0 ? args.n_event_loop : std::max(1, int(std::thread::hardware_concurrency()) / n_shard);
+    std::vector<std::unique_ptr<EventLoopShard>> shards;
+    shards.reserve(n_shard);
+
+    for (auto socket : sockets) {
+        auto& shard = *shards.emplace_back(std::make_unique<EventLoopShard>(args.max_socket, std::max(1024, args.max_socket)));
+        shard.socket = socket;
+        shard.epoll_fd = ::epoll_create1(0);
+        if (shard.epoll_fd < 0) {
+            return Err(log_error(errno, ::strerror));
+        }
+
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        if (::epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
+            return Err(log_error(errno, ::strerror));
+        }
 
-    epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = socket;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
-        return Err(log_error(errno, ::strerror));
+        shard.loops.reserve(n_loops);
+        for (int i = 0; i < n_loops; ++i) {
+            auto& loop = *shard.loops.emplace_back(std::make_unique<EventLoop>());
+            loop.epoll_fd = ::epoll_create1(0);
+            if (loop.epoll_fd < 0) {
+                return Err(log_error(errno, ::strerror));
+            }
+
+            loop.wake_fd = ::eventfd(0, EFD_NONBLOCK);
+            if (loop.wake_fd < 0) {
+                return Err(log_error(errno, ::strerror));
+            }
+
+            event.events = EPOLLIN;
+            event.data.fd = loop.wake_fd;
+            if (::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, loop.wake_fd, &event) < 0) {
+                return Err(log_error(errno, ::strerror));
+            }
+        }
     }
 
-    std::vector<std::thread> threads;
-    std::unordered_set<int> client_set;
-    std::deque<int> client_que;
-    std::mutex mtx;
-    std::condition_variable cv;
     std::atomic_bool is_running {true};
 
-    on_stop = [this, &is_running, &cv]() {
+    on_stop = [this, &is_running, &shards]() {
         is_running = false;
-        cv.notify_all();
+        for (auto& shard : shards) shard->wake();
+        on_queue_stats = {};
         on_stop = {};
     };
 
-    auto work = [this, file, line, &args, &is_running, &mtx, &cv, &client_set, &client_que](int idx) {
-        info(file, line, "Spawned worker thread: " + std::to_string(idx));
+    on_queue_stats = [&shards]() {
+        ServerQueueStats stats;
+        for (auto& shard : shards) delameta_detail_add_queue_stats(stats, shard->task_que);
+        return stats;
+    };
+
+    // close the connection and forget it, the caller must hold `loop.mtx`
+    auto close_connection = [file, line](EventLoop& loop, int fd, bool by_server) {
+        if (by_server) {
+            ::shutdown(fd, SHUT_RDWR);
+            INFO_AT(file, line, delameta_detail_log_format_fd(fd, "closed by server"));
+        } else {
+            INFO_AT(file, line, delameta_detail_log_format_fd(fd, "closed by peer"));
+        }
+        loop.connections.erase(fd);
+    };
+
+    // event loops: own the connections and only wake up when one of them becomes readable. with `buffer_http` a worker
+    // is woken only once the whole request has arrived, so a slow client doesn't hold it
+    auto poll_events = [file, line, &args, &is_running, &close_connection](EventLoopShard& shard, EventLoop& loop, int idx) {
+        INFO_AT(file, line, "Spawned event loop: " + std::to_string(idx));
+        std::vector<epoll_event> events(64);
+        auto last_sweep = Clock::now();
+
         while (is_running) {
-            int sock_client;
-            {
-                std::unique_lock<std::mutex> lock(mtx);
-                cv.wait(lock);
-                if (not is_running) break;
-                sock_client = client_que.front();
-                client_que.pop_front();
-            }
+            int num_events = ::epoll_wait(loop.epoll_fd, events.data(), events.size(), 1000);
+
+            for (int i = 0; i < num_events; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == loop.wake_fd) {
+                    uint64_t dummy;
+                    [[maybe_unused]] auto _ = ::read(loop.wake_fd, &dummy, sizeof(dummy));
+                    continue;
+                }
 
-            info(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
+                EventLoopConnection* conn;
+                {
+                    std::lock_guard<std::mutex> lock(loop.mtx);
+                    auto it = loop.connections.find(fd);
+                    if (it == loop.connections.end()) continue;
 
-            TCP session(file, line, sock_client, args.timeout);
-            session.keep_alive = args.keep_alive;
+                    // the peer is gone, whether it left a request behind or not there is nobody to answer
+                    if (events[i].events & (EPOLLHUP | EPOLLERR) or not (events[i].events & EPOLLIN)) {
+                        close_connection(loop, fd, false);
+                        continue;
+                    }
 
-            for (int cnt = 1; is_running and delameta_detail_is_socket_alive(sock_client); ++cnt) {
-                auto received_result = session.read(); // TODO: read() doesn't check for `is_running`
-                if (received_result.is_err()) {
-                    break;
+                    conn = &it->second;
                 }
 
-                auto stream = this->execute_stream_session(session, delameta_detail_get_ip(session.socket), received_result.unwrap());
-                stream >> session;
+                // the connection isn't busy, so only this thread touches it until it is handed to a worker
+                if (args.buffer_http) {
+                    if (conn->data.empty()) conn->last_active = Clock::now();
+                    bool open = conn->receive();
+                    if (not conn->request_ready()) {
+                        std::lock_guard<std::mutex> lock(loop.mtx);
+                        if (not open or not loop.arm(fd, EPOLL_CTL_MOD)) close_connection(loop, fd, open);
+                        continue;
+                    }
+                }
 
-                if (not session.keep_alive) {
-                    if (session.max > 0 and cnt >= session.max) {
-                        info(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
+                // push without holding `loop.mtx`, the workers need it to hand connections back
+                conn->busy = true;
+                if (not shard.task_que.push({&loop, conn})) {
+                    // every worker is a full queue behind, turn the client away instead of waiting for one
+                    if (not args.overload_response.empty()) {
+                        [[maybe_unused]] auto _ = ::send(fd, args.overload_response.data(), args.overload_response.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
                     }
-                    break;
+                    std::lock_guard<std::mutex> lock(loop.mtx);
+                    close_connection(loop, fd, true);
                 }
+            }
 
-                info(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
+            // close idle keep-alive connections
+            auto now = Clock::now();
+            if (now - last_sweep < 1s) continue;
+            last_sweep = now;
+
+            std::lock_guard<std::mutex> lock(loop.mtx);
+            for (auto it = loop.connections.begin(); it != loop.connections.end();) {
+                auto& [fd, conn] = *it++;
+                int timeout_ms = conn.session->timeout_ms;
+                if (conn.busy or timeout_ms < 0 or now - conn.last_active < std::chrono::milliseconds(timeout_ms)) continue;
+                close_connection(loop, fd, true);
             }
+        }
+    };
 
-            // shutdown if still connected
-            if (delameta_detail_is_socket_alive(session.socket)) {
-                ::shutdown(session.socket, SHUT_RDWR);
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
-            } else {
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
+    // workers: serve exactly one request of a readable connection, then hand it back to its loop
+    auto work = [this, file, line, &args, &is_running, &close_connection](EventLoopShard& shard, int idx) {
+        INFO_AT(file, line, "Spawned worker thread: " + std::to_string(idx));
+        while (is_running) {
+            Task task;
+            if (not shard.task_que.pop(task)) continue;
+
+            auto& [loop, conn] = task;
+            auto& session = *conn->session;
+            int fd = session.socket;
+
+            // the request has been buffered by the loop already unless `buffer_http` is off
+            bool received = true;
+            if (not args.buffer_http) {
+                auto received_result = session.read_buffer();
+                received = received_result.is_ok();
+                if (received) conn->data.assign(received_result.unwrap().begin(), received_result.unwrap().end());
+            }
+
+            bool keep = received;
+            if (keep) {
+                DeadlineScope scope(session, session.timeout_ms);
+                auto stream = this->execute_stream_session(session, conn->ip, conn->data);
+                stream >> session;
+                keep = session.keep_alive;
             }
+            conn->reset();
 
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                client_set.erase(sock_client);
+            std::lock_guard<std::mutex> lock(loop->mtx);
+            if (keep and loop->arm(fd, EPOLL_CTL_MOD)) {
+                conn->busy = false;
+                conn->last_active = Clock::now();
+                INFO_AT(file, line, delameta_detail_log_format_fd(fd, "kept alive"));
+            } else {
+                close_connection(*loop, fd, received);
             }
         }
     };
 
-    threads.reserve(args.max_socket);
-    client_set.reserve(args.max_socket);
-    for (int i = 0; i < args.max_socket; ++i) {
-        threads.emplace_back(work, i);
-    }
+    // acceptor: distribute new connections to the event loops of its shard in round robin
+    auto accept_clients = [this, file, line, &args, &is_running, &poll_events, &work](EventLoopShard& shard, int cpu) -> Result<void> {
+        delameta_detail_pin_thread(cpu);
+
+        std::vector<std::thread> threads;
+        threads.reserve(shard.loops.size() + args.max_socket);
+        for (size_t i = 0; i < shard.loops.size(); ++i) {
+            threads.emplace_back([&poll_events, &shard, cpu, i]() {
+                delameta_detail_pin_thread(cpu);
+                poll_events(shard, *shard.loops[i], i);
+            });
+        }
+        for (int i = 0; i < args.max_socket; ++i) {
+            threads.emplace_back([&work, &shard, cpu, i]() {
+                delameta_detail_pin_thread(cpu);
+                work(shard, i);
+            });
+        }
 
-    while (is_running) {
-        std::vector<epoll_event> events(args.max_socket);
-        int num_events = epoll_wait(epoll_fd, events.data(), args.max_socket, 10);
+        size_t next_loop = 0;
+        std::vector<epoll_event> events(1);
+        while (is_running) {
+            int num_events = ::epoll_wait(shard.epoll_fd, events.data(), events.size(), 10);
+            if (num_events <= 0) continue;
 
-        for (int i = 0; i < num_events; ++i) if (events[i].data.fd == socket)
-        {
-            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
-                WARNING("Epoll error or hang-up detected on fd: " + std::to_string(events[i].data.fd));
+            if (events[0].events & (EPOLLERR | EPOLLHUP)) {
+                WARNING("Epoll error or hang-up detected on fd: " + std::to_string(shard.socket));
                 continue;
             }
 
-            int new_sock_client = ::accept(socket, nullptr, nullptr);
-            if (new_sock_client < 0) {
-                if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINPROGRESS) {
-                    WARNING(delameta_detail_log_format_fd(socket, "accept() failed, ") + strerror(errno_));
+            for (;;) {
+                int new_sock_client = ::accept4(shard.socket, nullptr, nullptr, SOCK_NONBLOCK);
+                if (new_sock_client < 0) {
+                    if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINPROGRESS) {
+                        WARNING(delameta_detail_log_format_fd(shard.socket, "accept() failed, ") + strerror(errno_));
+                    }
+                    break;
                 }
-                continue;
-            }
 
-            std::lock_guard<std::mutex> lock(mtx);
-            if ((int)client_set.size() >= args.max_socket) {
-                ::shutdown(new_sock_client, SHUT_RDWR);
-                WARNING(delameta_detail_log_format_fd(socket, "Thread pool is full"));
-                continue;
-            }
+                auto& loop = *shard.loops[next_loop++ % shard.loops.size()];
+                std::lock_guard<std::mutex> lock(loop.mtx);
+                auto [it, ok] = loop.connections.try_emplace(new_sock_client);
+                if (not ok) {
+                    WARNING(delameta_detail_log_format_fd(new_sock_client, "Duplicate socket"));
+                    continue;
+                }
 
-            auto [_, ok] = client_set.insert(new_sock_client);
-            if (not ok) {
-                WARNING(delameta_detail_log_format_fd(new_sock_client, "Duplicate socket"));
-                continue;
+                auto& conn = it->second;
+                conn.session.reset(new TCP(file, line, new_sock_client, timeout_ms_of(args.timeout, args.timeout_ms)));
+                conn.session->keep_alive = args.keep_alive;
+                conn.ip = delameta_detail_get_ip(new_sock_client);
+                conn.last_active = Clock::now();
+
+                if (not loop.arm(new_sock_client, EPOLL_CTL_ADD)) {
+                    WARNING(delameta_detail_log_format_fd(new_sock_client, "epoll_ctl() failed, ") + strerror(errno));
+                    loop.connections.erase(it);
+                }
             }
+        }
 
-            client_que.push_back(new_sock_client);
-            cv.notify_one();
+        for (auto& thd : threads) if (thd.joinable()) {
+            thd.join();
         }
-    }
+        return Ok();
+    };
 
-    for (auto& thd : threads) if (thd.joinable()) {
-        thd.join();
-    }
-    return Ok();
+    return delameta_detail_run_shards(n_shard, [&args, &shards, &accept_clients](int idx) {
+        return accept_clients(*shards[idx], args.pin_cpu ? idx : -1);
+    });
 }
 
 void Server<TCP>::stop() {
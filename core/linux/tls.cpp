@@ -22,8 +22,8 @@ TLS::TLS(TCP&& tcp, void* ssl)
     : TCP(std::move(tcp)) 
     , ssl(ssl) {}
 
-TLS::TLS(const char* file, int line, int socket, int timeout, void* ssl)
-    : TCP(file, line, socket, timeout)
+TLS::TLS(const char* file, int line, int socket, int timeout_ms, void* ssl)
+    : TCP(file, line, socket, timeout_ms)
     , ssl(ssl) {}
 
 TLS::TLS(TLS&& other)
@@ -40,6 +40,14 @@ auto TLS::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TLS::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto TLS::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -48,6 +56,14 @@ auto TLS::write(std::string_view data) -> Result<void> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TLS::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset); // the data has to go through SSL_write()
+}
+
 auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
     NOT_IMPLEMENTED
 }
@@ -63,16 +79,13 @@ void Server<TLS>::stop() {}
 #include <openssl/err.h>
 #include <cerrno>
 #include <cstring>
-#include <unordered_set>
-#include <deque>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
 
 // Unix/Linux headers and definitions
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -132,10 +145,18 @@ static void ssl_deinit() {
     }
 }
 
-static auto ssl_handshake(const char* file, int line, int socket, bool as_server) -> Result<SSL*> {
+// gives up with Error::TransferTimeout after `timeout_ms`, or at `deadline` if that is earlier
+static auto ssl_handshake(const char* file, int line, int socket, bool as_server, int timeout_ms, Deadline deadline = {}) -> Result<SSL*> {
     auto [_, err] = ssl_init();
     if (err) return Err(std::move(*err));
 
+    if (timeout_ms >= 0) {
+        deadline = earliest(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+    }
+
+    // a blocking socket would wait inside SSL_accept()/SSL_connect() regardless of the deadline
+    delameta_detail_set_non_blocking(socket);
+
     auto ssl = SSL_new(as_server ? ssl_context_server : ssl_context_client);
     SSL_set_fd(ssl, socket);
 
@@ -147,21 +168,26 @@ static auto ssl_handshake(const char* file, int line, int socket, bool as_server
 
         int ssl_error = SSL_get_error(ssl, res);
         if (ssl_error == SSL_ERROR_WANT_READ) {
-            // Wait for the socket to be ready for reading (use select/poll/epoll)
-            info(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be readable..."));
+            // Wait for the socket to be ready for reading
+            INFO_AT(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be readable..."));
+            if (delameta_detail_wait_fd(socket, POLLIN, timeout_left(-1, deadline)) == 0) break;
         } else if (ssl_error == SSL_ERROR_WANT_WRITE) {
             // Wait for the socket to be ready for writing
-            info(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be writable..."));
+            INFO_AT(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be writable..."));
+            if (delameta_detail_wait_fd(socket, POLLOUT, timeout_left(-1, deadline)) == 0) break;
         } else {
-            warning(file, line, delameta_detail_log_format_fd(socket, "SSL handshake failed: " + std::to_string(ssl_error)));
+            WARNING_AT(file, line, delameta_detail_log_format_fd(socket, "SSL handshake failed: " + std::to_string(ssl_error)));
             break;
         }
-
-        std::this_thread::sleep_for(10ms);
     }
 
     if (res <= 0) {
+        SSL_free(ssl);
         --ssl_counter;
+        if (deadline != Deadline{} and timeout_left(-1, deadline) == 0) {
+            WARNING_AT(file, line, delameta_detail_log_format_fd(socket, "SSL handshake timed out"));
+            return Err(Error::TransferTimeout);
+        }
         return Err(ssl_get_error());
     }
 
@@ -217,26 +243,23 @@ static auto ssl_context_configure(bool is_server, const std::string& cert_file,
     return Ok();
 }
 
-static bool is_tls_alive(int) {
-    return true;
-}
-
 auto TLS::Open(const char* file, int line, Args args) -> Result<TLS> {
     auto [tcp, tcp_err] = TCP::Open(file, line, TCP::Args{
         .host=args.host, 
         .timeout=args.timeout, 
+        .timeout_ms=args.timeout_ms,
         .connection_timeout=args.connection_timeout
     });
     if (tcp_err) return Err(std::move(*tcp_err));
 
-    delameta_detail_set_blocking(tcp->socket);
-
     auto [_, conf_err] = ssl_context_configure(false, args.cert_file, "");
     if (conf_err) return Err(std::move(*conf_err));
 
-    auto [ssl, ssl_err] = ssl_handshake(file, line, tcp->socket, false);
+    auto [ssl, ssl_err] = ssl_handshake(file, line, tcp->socket, false, timeout_ms_of(args.timeout, args.timeout_ms));
     if (ssl_err) return Err(std::move(*ssl_err));
 
+    delameta_detail_set_blocking(tcp->socket);
+
     --ssl_counter;
     return Ok(TLS(std::move(*tcp), *ssl));
 }
@@ -245,8 +268,8 @@ TLS::TLS(TCP&& tcp, void* ssl)
     : TCP(std::move(tcp)) 
     , ssl(ssl) {}
 
-TLS::TLS(const char* file, int line, int socket, int timeout, void* ssl)
-    : TCP(file, line, socket, timeout)
+TLS::TLS(const char* file, int line, int socket, int timeout_ms, void* ssl)
+    : TCP(file, line, socket, timeout_ms)
     , ssl(ssl) {}
 
 TLS::TLS(TLS&& other)
@@ -261,184 +284,140 @@ TLS::~TLS() {
 }
 
 auto TLS::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read(file, line, socket, ssl, timeout, &is_tls_alive);
+    return delameta_detail_read(file, line, socket, ssl, timeout_left(timeout_ms, deadline));
 }
 
 auto TLS::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read_until(file, line, socket, ssl, timeout, &is_tls_alive, n);
+    return delameta_detail_read_until(file, line, socket, ssl, timeout_left(timeout_ms, deadline), n);
+}
+
+auto TLS::read_buffer() -> Result<Buffer> {
+    return delameta_detail_read_buffer(file, line, socket, ssl, timeout_left(timeout_ms, deadline));
+}
+
+auto TLS::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return delameta_detail_read_into(file, line, socket, ssl, timeout_left(timeout_ms, Descriptor::deadline), deadline, buf, cap);
 }
 
 auto TLS::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto TLS::write(std::string_view data) -> Result<void> {
-    return delameta_detail_write(file, line, socket, ssl, timeout, &is_tls_alive, data);
+    return delameta_detail_write(file, line, socket, ssl, timeout_left(timeout_ms, deadline), true, data);
+}
+
+auto TLS::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n); // SSL has no gather write, the pieces are joined into one SSL_write()
+}
+
+auto TLS::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset); // the data has to go through SSL_write()
 }
 
 auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
     if (args.max_socket <= 0) {
         return Err("Invalid max socket value, must be positive integer");
     }
+    if (args.n_shard <= 0) {
+        return Err("Invalid shard value, must be positive integer");
+    }
+    if (args.max_pending < 0) {
+        return Err("Invalid max pending value, must be non-negative integer");
+    }
 
     LogError log_error{file, line};
-    auto [resolve, resolve_err] = delameta_detail_resolve_domain(args.host, SOCK_STREAM, true);
-    if (resolve_err) return Err(log_error(*resolve_err, ::gai_strerror));
+    auto [listen, listen_err] = delameta_detail_listen(log_error, args.host, args.max_socket + args.max_pending, args.n_shard);
+    if (listen_err) return Err(std::move(*listen_err));
 
-    auto hint = *resolve;
-    auto defer_hint = defer | [hint]() { ::freeaddrinfo(hint); };
-
-    auto [sock, sock_err] = delameta_detail_create_socket(hint, log_error);
-    if (sock_err) return Err(std::move(*sock_err));
-
-    auto socket = *sock;
-    auto defer_socket = defer | [socket]() { delameta_detail_close_socket(socket); };
-
-    if (::bind(socket, hint->ai_addr, hint->ai_addrlen) < 0) {
-        return Err(log_error(errno, ::strerror));
-    }
-
-    if (::listen(socket, args.max_socket) < 0) {
-        return Err(log_error(errno, ::strerror));
-    }
+    auto sockets = std::move(*listen);
+    auto defer_sockets = defer | [&sockets]() { for (auto socket : sockets) delameta_detail_close_socket(socket); };
 
     auto [_, conf_err] = ssl_context_configure(true, args.cert_file, args.key_file);
     if (conf_err) return Err(std::move(*conf_err));
 
     auto defer_conf = defer | &ssl_deinit;
 
-    int epoll_fd = ::epoll_create1(0);
-    if (epoll_fd < 0) {
-        return Err(log_error(errno, ::strerror));
-    }
-
-    auto defer_epoll = defer | [epoll_fd]() { ::close(epoll_fd); };
-
-    epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = socket;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
-        return Err(log_error(errno, ::strerror));
+    std::vector<std::unique_ptr<AcceptorPool>> pools;
+    pools.reserve(sockets.size());
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        pools.push_back(std::make_unique<AcceptorPool>(file, line, sockets[i], AcceptorPool::Args{
+            .max_socket=args.max_socket,
+            .max_pending=args.max_pending,
+            .max_pending_ms=args.max_pending_ms,
+            .cpu=args.pin_cpu ? int(i) : -1,
+        }));
     }
 
-    std::vector<std::thread> threads;
-    std::unordered_set<int> client_set;
-    std::deque<int> client_que;
-    std::mutex mtx;
-    std::condition_variable cv;
     std::atomic_bool is_running {true};
 
-    on_stop = [this, &is_running, &cv]() { 
+    on_stop = [this, &is_running, &pools]() { 
         is_running = false;
-        cv.notify_all();
+        for (auto& pool : pools) pool->wake();
+        on_queue_stats = {};
         on_stop = {};
     };
 
-    auto work = [this, file, line, &args, &is_running, &mtx, &cv, &client_set, &client_que](int idx) {
-        info(file, line, "Spawned worker thread: " + std::to_string(idx));
-        while (is_running) {
-            int sock_client;
-            {
-                std::unique_lock<std::mutex> lock(mtx);
-                cv.wait(lock);
-                if (not is_running) break;
-                sock_client = client_que.front();
-                client_que.pop_front();
-            }
-
-            auto [ssl, ssl_err] = ssl_handshake(file, line, sock_client, true);
-            if (ssl_err) {
-                std::lock_guard<std::mutex> lock(mtx);
-                client_set.erase(sock_client);
-                delameta_detail_close_socket(sock_client);
-                continue;
-            }
-
-            info(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
-
-            TLS session(file, line, sock_client, 1, *ssl);
-            session.keep_alive = args.keep_alive;
-
-            for (int cnt = 1; is_running and is_tls_alive(sock_client); ++cnt) {
-                auto received_result = session.read(); // TODO: read() doesn't check for is_running
-                if (received_result.is_err()) {
-                    break;
-                }
-
-                auto stream = this->execute_stream_session(session, delameta_detail_get_ip(session.socket), received_result.unwrap());
-                stream >> session;
+    on_queue_stats = [&pools]() {
+        ServerQueueStats stats;
+        for (auto& pool : pools) delameta_detail_add_queue_stats(stats, pool->queue());
+        return stats;
+    };
 
-                if (not session.keep_alive) {
-                    if (session.max > 0 and cnt >= session.max) {
-                        info(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
-                    }
-                    break;
-                }
+    auto serve = [this, file, line, &args, &is_running](int sock_client, int idx) {
+        auto [ssl, ssl_err] = ssl_handshake(file, line, sock_client, true, timeout_ms_of(args.timeout, args.timeout_ms));
+        if (ssl_err) {
+            delameta_detail_close_socket(sock_client);
+            return;
+        }
 
-                info(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
-            }
+        INFO_AT(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
 
-            // shutdown if still connected
-            if (is_tls_alive(sock_client)) {
-                SSL_shutdown(*ssl);
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
-            } else {
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
-            }
+        TLS session(file, line, sock_client, timeout_ms_of(args.timeout, args.timeout_ms), *ssl);
+        session.keep_alive = args.keep_alive;
+        std::vector<uint8_t> data; // reused by every request of this connection
+        auto ip = delameta_detail_get_ip(sock_client);
+        bool closed_by_peer = false;
 
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                client_set.erase(sock_client);
+        for (int cnt = 1; is_running; ++cnt) {
+            auto received_result = session.read_buffer(); // TODO: read() doesn't check for is_running
+            if (received_result.is_err()) {
+                closed_by_peer = received_result.unwrap_err().code == Error::ConnectionClosed;
+                break;
             }
-        }
-    };
 
-    threads.reserve(args.max_socket);
-    for (int i = 0; i < args.max_socket; ++i) {
-        threads.emplace_back(work, i);
-    }
-
-    while (is_running) {
-        std::vector<epoll_event> events(args.max_socket);
-        int num_events = epoll_wait(epoll_fd, events.data(), args.max_socket, 10);
+            auto& received = received_result.unwrap();
+            data.assign(received.begin(), received.end());
 
-        for (int i = 0; i < num_events; ++i) if (events[i].data.fd == socket)
-        {
-            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
-                WARNING("Epoll error or hang-up detected on fd: " + std::to_string(events[i].data.fd));
-                continue;
-            }
+            // the rest of the request and the response share one deadline
+            DeadlineScope scope(session, session.timeout_ms);
+            auto stream = this->execute_stream_session(session, ip, data);
+            stream >> session;
 
-            int new_sock_client = ::accept(socket, nullptr, nullptr);
-            if (new_sock_client < 0) {
-                if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINPROGRESS) {
-                    WARNING(delameta_detail_log_format_fd(socket, "accept() failed, ") + strerror(errno_));
+            if (not session.keep_alive) {
+                if (session.max > 0 and cnt >= session.max) {
+                    INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
                 }
-                continue;
-            }
-
-            std::lock_guard<std::mutex> lock(mtx);
-            if ((int)client_set.size() >= args.max_socket) {
-                ::shutdown(new_sock_client, SHUT_RDWR);
-                WARNING(delameta_detail_log_format_fd(socket, "Thread pool is full"));
-                continue;
+                break;
             }
 
-            auto [_, ok] = client_set.insert(new_sock_client);
-            if (not ok) {
-                WARNING(delameta_detail_log_format_fd(new_sock_client, "Duplicate socket"));
-                continue;
-            }
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
+        }
 
-            client_que.push_back(new_sock_client);
-            cv.notify_one(); // notify thread pool
+        // shutdown if still connected
+        if (not closed_by_peer) {
+            SSL_shutdown(*ssl);
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
+        } else {
+            INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
         }
-    }
+    };
 
-    for (auto& thd : threads) if (thd.joinable()) {
-        thd.join();
-    }
-    return etl::Ok();
+    return delameta_detail_run_shards(pools.size(), [this, &pools, &is_running, &serve](int idx) {
+        auto res = pools[idx]->run(is_running, serve);
+        if (res.is_err()) stop();
+        return res;
+    });
 }
 
 void Server<TLS>::stop() {
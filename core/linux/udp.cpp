@@ -8,6 +8,7 @@
 
 // Unix/Linux headers and definitions
 #include <sys/socket.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -39,33 +40,37 @@ auto UDP::Open(const char* file, int line, Args args) -> Result<UDP> {
         return Err(log_error(errno, ::strerror));
     }
 
-    info(file, line, "Created UDP socket: " + std::to_string(socket));
+    INFO_AT(file, line, "Created UDP socket: " + std::to_string(socket));
 
-    return Ok(UDP(file, line, socket, args.timeout, hint));
+    return Ok(UDP(file, line, socket, timeout_ms_of(args.timeout, args.timeout_ms), hint));
 }
 
-UDP::UDP(const char* file, int line, int socket, int timeout, void* peer)
+UDP::UDP(const char* file, int line, int socket, int timeout_ms, void* peer)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , peer(peer)
     , file(file)
-    , line(line) { delameta_detail_set_non_blocking(socket); }
+    , line(line)
+{
+    request_timeout_ms = timeout_ms;
+    delameta_detail_set_non_blocking(socket);
+}
 
 UDP::UDP(UDP&& other)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , peer(std::exchange(other.peer, nullptr))
     , file(other.file)
-    , line(other.line) {}
+    , line(other.line) { request_timeout_ms = other.request_timeout_ms; }
 
 UDP::~UDP() {
     if (socket >= 0) {
         delameta_detail_close_socket(socket);
-        info(file, line, "Closed UDP socket: " + std::to_string(socket));
+        INFO_AT(file, line, "Closed UDP socket: " + std::to_string(socket));
         socket = -1;
     } 
     if (peer) {
@@ -74,25 +79,33 @@ UDP::~UDP() {
 }
 
 auto UDP::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_recvfrom(file, line, socket, timeout, peer);
+    return delameta_detail_recvfrom(file, line, socket, timeout_left(timeout_ms, deadline), peer);
 }
 
 auto UDP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_recvfrom_until(file, line, socket, timeout, peer, n);
+    return delameta_detail_recvfrom_until(file, line, socket, timeout_left(timeout_ms, deadline), peer, n);
+}
+
+auto UDP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return delameta_detail_recvfrom_into(file, line, socket, timeout_left(timeout_ms, Descriptor::deadline), deadline, peer, buf, cap);
 }
 
 auto UDP::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto UDP::write(std::string_view data) -> Result<void> {
-    return delameta_detail_sendto(file, line, socket, timeout, peer, data);
+    return delameta_detail_sendto(file, line, socket, timeout_left(timeout_ms, deadline), peer, data);
 }
 
 auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
-    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout});
+    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout, args.timeout_ms});
     if (err) return Err(std::move(*err));
 
+    if (args.n_worker > 0) {
+        return start_worker_pool(file, line, args, *udp);
+    }
+
     std::list<std::thread> threads;
     std::mutex mtx;
     std::atomic_bool is_running {true};
@@ -106,7 +119,7 @@ auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
         on_stop = {};
     };
 
-    while (is_running and delameta_detail_is_socket_alive(udp->socket)) {
+    while (is_running) {
         auto sa_in = new ::sockaddr_in();
         auto ai = new ::addrinfo();
         ::memset(sa_in, 0, sizeof(::sockaddr_in));
@@ -114,7 +127,7 @@ auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
         ai->ai_addr = reinterpret_cast<::sockaddr*>(sa_in);
         ai->ai_addrlen = sizeof(sockaddr_in);
 
-        UDP session(file, line, udp->socket, udp->timeout, ai);
+        UDP session(file, line, udp->socket, udp->timeout_ms, ai);
 
         auto read_result = session.read();
         if (read_result.is_err()) {
@@ -160,6 +173,155 @@ auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
     return Ok();
 }
 
+namespace {
+    // one per worker, reused for every datagram of every batch. replies are queued and sent with sendmmsg
+    // once the whole batch has been handled
+    class BatchSession : public UDP {
+    public:
+        struct Reply {
+            size_t slot;
+            std::string data;
+        };
+
+        BatchSession(const char* file, int line, int socket, int timeout_ms)
+            : UDP(file, line, socket, timeout_ms, nullptr) {}
+
+        ~BatchSession() {
+            socket = -1; // the socket is owned by the server
+            peer = nullptr; // the peers are owned by the worker
+        }
+
+        Result<void> write(std::string_view data) override {
+            auto& reply = n_reply < replies.size() ? replies[n_reply] : replies.emplace_back();
+            reply.slot = slot;
+            reply.data.assign(data.data(), data.size());
+            ++n_reply;
+            return Ok();
+        }
+        using Descriptor::write;
+
+        size_t slot = 0;
+        size_t n_reply = 0;
+        std::vector<Reply> replies;
+    };
+}
+
+auto Server<UDP>::start_worker_pool(const char* file, int line, const Args& args, UDP& udp) -> Result<void> {
+    if (args.batch <= 0) {
+        return Err("Invalid batch value, must be positive integer");
+    }
+
+    std::atomic_bool is_running {true};
+
+    on_stop = [this, &is_running]() {
+        is_running = false;
+        on_stop = {};
+    };
+
+    auto work = [this, file, line, &args, &udp, &is_running](int idx) {
+        INFO_AT(file, line, "Spawned worker thread: " + std::to_string(idx));
+
+        // preallocated slots: a buffer, a peer address and a message header for every datagram of a batch
+        const size_t n = args.batch;
+        std::vector<uint8_t> buffers(n * args.max_datagram);
+        std::vector<::sockaddr_storage> peers(n);
+        std::vector<::addrinfo> ais(n);
+        std::vector<::iovec> iovs(n);
+        std::vector<::mmsghdr> msgs(n);
+        std::vector<uint8_t> data;
+
+        BatchSession session(file, line, udp.socket, udp.timeout_ms);
+
+        while (is_running) {
+            if (delameta_detail_wait_fd(udp.socket, POLLIN, 100) <= 0) continue;
+
+            for (size_t i = 0; i < n; ++i) {
+                iovs[i] = {buffers.data() + i * args.max_datagram, args.max_datagram};
+                msgs[i] = {};
+                msgs[i].msg_hdr.msg_name = &peers[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(::sockaddr_storage);
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            int received = ::recvmmsg(udp.socket, msgs.data(), n, MSG_DONTWAIT, nullptr);
+            if (received < 0) {
+                if (auto errno_ = errno; errno_ != EWOULDBLOCK && errno_ != EINTR) {
+                    WARNING(delameta_detail_log_format_fd(udp.socket, "recvmmsg() failed, ") + strerror(errno_));
+                }
+                continue;
+            }
+
+            session.n_reply = 0;
+            for (int i = 0; i < received; ++i) {
+                auto& hdr = msgs[i].msg_hdr;
+                if (hdr.msg_flags & MSG_TRUNC) {
+                    WARNING(delameta_detail_log_format_fd(udp.socket, "datagram is larger than max_datagram, dropped"));
+                    continue;
+                }
+
+                ais[i] = {};
+                ais[i].ai_family = peers[i].ss_family;
+                ais[i].ai_addr = reinterpret_cast<::sockaddr*>(&peers[i]);
+                ais[i].ai_addrlen = hdr.msg_namelen;
+                session.peer = &ais[i];
+                session.slot = i;
+
+                char ip_str[INET6_ADDRSTRLEN] = {};
+                if (peers[i].ss_family == AF_INET6) {
+                    ::inet_ntop(AF_INET6, &reinterpret_cast<::sockaddr_in6*>(&peers[i])->sin6_addr, ip_str, sizeof(ip_str));
+                } else {
+                    ::inet_ntop(AF_INET, &reinterpret_cast<::sockaddr_in*>(&peers[i])->sin_addr, ip_str, sizeof(ip_str));
+                }
+
+                auto begin = buffers.data() + i * args.max_datagram;
+                data.assign(begin, begin + msgs[i].msg_len);
+
+                auto stream = execute_stream_session(session, ip_str, data);
+                stream >> session;
+            }
+
+            // send the replies of the whole batch back, reusing the slots of the received datagrams
+            for (size_t sent = 0; sent < session.n_reply;) {
+                size_t count = std::min(n, session.n_reply - sent);
+                for (size_t i = 0; i < count; ++i) {
+                    auto& reply = session.replies[sent + i];
+                    iovs[i] = {reply.data.data(), reply.data.size()};
+                    msgs[i] = {};
+                    msgs[i].msg_hdr.msg_name = &peers[reply.slot];
+                    msgs[i].msg_hdr.msg_namelen = ais[reply.slot].ai_addrlen;
+                    msgs[i].msg_hdr.msg_iov = &iovs[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                }
+
+                int res = ::sendmmsg(udp.socket, msgs.data(), count, MSG_DONTWAIT);
+                if (res > 0) {
+                    sent += res;
+                    continue;
+                }
+
+                if (auto errno_ = errno; res == 0 or (errno_ != EWOULDBLOCK and errno_ != EINTR)) {
+                    WARNING(delameta_detail_log_format_fd(udp.socket, "sendmmsg() failed, ") + strerror(errno_));
+                    break;
+                }
+                if (not is_running) break;
+                delameta_detail_wait_fd(udp.socket, POLLOUT, 100);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(args.n_worker);
+    for (int i = 0; i < args.n_worker; ++i) {
+        threads.emplace_back(work, i);
+    }
+
+    for (auto& thd : threads) if (thd.joinable()) {
+        thd.join();
+    }
+    return Ok();
+}
+
 void Server<UDP>::stop() {
     if (on_stop) {
         on_stop();
@@ -0,0 +1,529 @@
+#include "helper.h"
+#include <cstring>
+#include <mutex>
+
+using namespace Project;
+using namespace Project::delameta;
+
+using etl::Err;
+using etl::Ok;
+
+#ifdef DELAMETA_ENABLE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static auto log_err(const char* file, int line, int fd, Error err) {
+    WARNING_AT(file, line, delameta_detail_log_format_fd(fd, err.what));
+    return Err(std::move(err));
+}
+
+// map a negative cqe result to an error, `timed_out` tells whether the linked timeout has fired
+static auto cqe_error(int res, bool timed_out) -> Error {
+    if (timed_out) return Error::TransferTimeout;
+    if (res == -EPIPE || res == -ECONNRESET) return Error::ConnectionClosed;
+    return Error(-res, ::strerror(-res));
+}
+
+namespace {
+    // Minimal io_uring ring owned by a single thread. An operation and its linked timeout are submitted together
+    // and reaped with one io_uring_enter(), reads land in a buffer registered with the kernel up front
+    class Ring {
+    public:
+        static constexpr unsigned n_entries = 8;
+        static constexpr size_t buffer_size = 64 * 1024;
+
+        // user data of the sqes, each submission uses at most one of every kind
+        enum Slot : uint64_t { OP, OP2, TIMEOUT, N_SLOT };
+
+        ~Ring();
+
+        bool init();
+
+        // queue an sqe for `slot`, the next queued sqe is linked to it when `link` is set
+        io_uring_sqe& prepare(Slot slot, uint8_t opcode, int fd, bool link);
+
+        // queue a timeout linked to the previous sqe, nothing is queued for a negative timeout
+        bool prepare_timeout(Clock::time_point start, int timeout_ms);
+        void prepare_timeout(Clock::duration left);
+
+        // drop the pipe with whatever is stuck in it and open a new one
+        bool reset_pipe();
+
+        // submit everything queued and wait for all of it to complete, results are stored in `res`
+        bool submit_and_wait();
+
+        int res[N_SLOT] = {};
+        bool timed_out() const { return has_timeout and res[TIMEOUT] == -ETIME; }
+
+        uint8_t* buffer() { return buffer_.data(); }
+
+        int pipe_fd[2] = {-1, -1};
+        size_t pipe_capacity = 0;
+
+    private:
+        int fd = -1;
+        unsigned queued = 0;
+        bool has_timeout = false;
+        __kernel_timespec ts = {};
+
+        void* sq_ptr = MAP_FAILED;
+        void* cq_ptr = MAP_FAILED;
+        size_t sq_size = 0, cq_size = 0;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t sqes_size = 0;
+
+        unsigned *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+        unsigned *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+
+        std::vector<uint8_t> buffer_ = std::vector<uint8_t>(buffer_size);
+    };
+
+    thread_local std::unique_ptr<Ring> ring;
+}
+
+Ring::~Ring() {
+    if (pipe_fd[0] >= 0) { ::close(pipe_fd[0]); ::close(pipe_fd[1]); }
+    if (sqes != MAP_FAILED) ::munmap(sqes, sqes_size);
+    if (cq_ptr != MAP_FAILED and cq_ptr != sq_ptr) ::munmap(cq_ptr, cq_size);
+    if (sq_ptr != MAP_FAILED) ::munmap(sq_ptr, sq_size);
+    if (fd >= 0) ::close(fd);
+}
+
+bool Ring::init() {
+    io_uring_params p = {};
+    fd = ::syscall(__NR_io_uring_setup, n_entries, &p);
+    if (fd < 0) return false;
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+
+    sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) return false;
+
+    cq_ptr = p.features & IORING_FEAT_SINGLE_MMAP ? sq_ptr :
+        ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) return false;
+
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) return false;
+
+    auto sq = static_cast<uint8_t*>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+
+    auto cq = static_cast<uint8_t*>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    iovec iov = {buffer_.data(), buffer_.size()};
+    if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0) return false;
+
+    return reset_pipe();
+}
+
+io_uring_sqe& Ring::prepare(Slot slot, uint8_t opcode, int fd, bool link) {
+    if (queued == 0) {
+        has_timeout = false;
+        std::fill(std::begin(res), std::end(res), 0);
+    }
+
+    unsigned tail = *sq_tail + queued++;
+    unsigned idx = tail & *sq_mask;
+    auto& sqe = sqes[idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.user_data = slot;
+    sqe.flags = link ? IOSQE_IO_LINK : 0;
+    sq_array[idx] = idx;
+    return sqe;
+}
+
+bool Ring::prepare_timeout(Clock::time_point start, int timeout_ms) {
+    if (timeout_ms < 0) return false;
+    prepare_timeout(std::chrono::milliseconds(timeout_ms) - (Clock::now() - start));
+    return true;
+}
+
+void Ring::prepare_timeout(Clock::duration left) {
+    auto ns = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(left).count());
+    ts.tv_sec = ns / 1'000'000'000;
+    ts.tv_nsec = ns % 1'000'000'000;
+
+    auto& sqe = prepare(TIMEOUT, IORING_OP_LINK_TIMEOUT, -1, false);
+    sqe.addr = reinterpret_cast<uint64_t>(&ts);
+    sqe.len = 1;
+    has_timeout = true;
+}
+
+bool Ring::reset_pipe() {
+    if (pipe_fd[0] >= 0) {
+        ::close(pipe_fd[0]);
+        ::close(pipe_fd[1]);
+        pipe_fd[0] = pipe_fd[1] = -1;
+    }
+    if (::pipe2(pipe_fd, O_CLOEXEC) < 0) return false;
+
+    auto sz = ::fcntl(pipe_fd[0], F_GETPIPE_SZ);
+    pipe_capacity = sz > 0 ? sz : 4096;
+    return true;
+}
+
+bool Ring::submit_and_wait() {
+    unsigned n = queued;
+    __atomic_store_n(sq_tail, *sq_tail + n, __ATOMIC_RELEASE);
+    queued = 0;
+
+    unsigned to_submit = n;
+    unsigned reaped = 0;
+    while (reaped < n) {
+        // the timeout must not outlive this call, so wait for every cqe even if the operation failed early
+        if (::syscall(__NR_io_uring_enter, fd, to_submit, n - reaped, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        to_submit = 0;
+
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head, ++reaped) {
+            auto& cqe = cqes[head & *cq_mask];
+            if (cqe.user_data < N_SLOT) res[cqe.user_data] = cqe.res;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+bool delameta_detail_uring_enable(const char* file, int line) {
+    if (ring) return true;
+
+    auto r = std::make_unique<Ring>();
+    if (not r->init()) {
+        WARNING_AT(file, line, std::string("io_uring is not available, ") + ::strerror(errno));
+        return false;
+    }
+
+    ring = std::move(r);
+    return true;
+}
+
+void delameta_detail_uring_disable() {
+    ring.reset();
+}
+
+bool delameta_detail_uring_active() {
+    return ring != nullptr;
+}
+
+// read once into the registered buffer, returns the number of bytes in it
+static auto read_fixed(const char* file, int line, int fd, int timeout_ms) -> Result<size_t> {
+    auto start = Clock::now();
+    auto& r = *ring;
+
+    auto& sqe = r.prepare(Ring::OP, IORING_OP_READ_FIXED, fd, timeout_ms >= 0);
+    sqe.addr = reinterpret_cast<uint64_t>(r.buffer());
+    sqe.len = Ring::buffer_size;
+    sqe.buf_index = 0;
+    r.prepare_timeout(start, timeout_ms);
+
+    if (not r.submit_and_wait()) {
+        return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+    }
+
+    int size = r.res[Ring::OP];
+    if (size < 0) {
+        return log_err(file, line, fd, cqe_error(size, r.timed_out()));
+    } else if (size == 0) {
+        return log_err(file, line, fd, Error::ConnectionClosed);
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(size) + " bytes"));
+    return Ok(size_t(size));
+}
+
+auto delameta_detail_uring_read(const char* file, int line, int fd, int timeout_ms) -> Result<std::vector<uint8_t>> {
+    auto [size, err] = read_fixed(file, line, fd, timeout_ms);
+    if (err) return Err(std::move(*err));
+    return Ok(std::vector<uint8_t>(ring->buffer(), ring->buffer() + *size));
+}
+
+auto delameta_detail_uring_read_buffer(const char* file, int line, int fd, int timeout_ms) -> Result<Buffer> {
+    auto [size, err] = read_fixed(file, line, fd, timeout_ms);
+    if (err) return Err(std::move(*err));
+
+    auto res = Buffer::acquire(*size);
+    std::copy(ring->buffer(), ring->buffer() + *size, res.begin());
+    return Ok(std::move(res));
+}
+
+auto delameta_detail_uring_read_into(
+    const char* file, int line, int fd, int timeout_ms, Deadline deadline, uint8_t* buf, size_t cap
+) -> Result<size_t> {
+    if (cap == 0) return Ok(0);
+
+    auto& r = *ring;
+    bool has_deadline = deadline != Deadline{} or timeout_ms >= 0;
+
+    // the caller buffer isn't registered, so this is a plain read instead of READ_FIXED
+    auto& sqe = r.prepare(Ring::OP, IORING_OP_READ, fd, has_deadline);
+    sqe.addr = reinterpret_cast<uint64_t>(buf);
+    sqe.len = std::min<size_t>(cap, UINT32_MAX);
+    if (deadline != Deadline{}) {
+        r.prepare_timeout(deadline - Clock::now());
+    } else {
+        r.prepare_timeout(Clock::now(), timeout_ms);
+    }
+
+    if (not r.submit_and_wait()) {
+        return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+    }
+
+    int size = r.res[Ring::OP];
+    if (size < 0) {
+        return log_err(file, line, fd, cqe_error(size, r.timed_out()));
+    } else if (size == 0) {
+        return log_err(file, line, fd, Error::ConnectionClosed);
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(size) + " bytes"));
+    return Ok(size_t(size));
+}
+
+auto delameta_detail_uring_read_until(const char* file, int line, int fd, int timeout_ms, size_t n) -> Result<std::vector<uint8_t>> {
+    auto start = Clock::now();
+    auto& r = *ring;
+    std::vector<uint8_t> buffer;
+    buffer.reserve(n);
+
+    while (buffer.size() < n) {
+        auto& sqe = r.prepare(Ring::OP, IORING_OP_READ_FIXED, fd, timeout_ms >= 0);
+        sqe.addr = reinterpret_cast<uint64_t>(r.buffer());
+        sqe.len = std::min(Ring::buffer_size, n - buffer.size());
+        sqe.buf_index = 0;
+        r.prepare_timeout(start, timeout_ms);
+
+        if (not r.submit_and_wait()) {
+            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+        }
+
+        int size = r.res[Ring::OP];
+        if (size < 0) {
+            return log_err(file, line, fd, cqe_error(size, r.timed_out()));
+        } else if (size == 0) {
+            return log_err(file, line, fd, Error::ConnectionClosed);
+        }
+
+        buffer.insert(buffer.end(), r.buffer(), r.buffer() + size);
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(buffer.size()) + " bytes"));
+    return Ok(std::move(buffer));
+}
+
+auto delameta_detail_uring_write(const char* file, int line, int fd, int timeout_ms, std::string_view data) -> Result<void> {
+    auto start = Clock::now();
+    auto& r = *ring;
+
+    for (size_t i = 0; i < data.size();) {
+        auto& sqe = r.prepare(Ring::OP, IORING_OP_SEND, fd, timeout_ms >= 0);
+        sqe.addr = reinterpret_cast<uint64_t>(data.data() + i);
+        sqe.len = data.size() - i;
+        sqe.msg_flags = MSG_NOSIGNAL;
+        r.prepare_timeout(start, timeout_ms);
+
+        if (not r.submit_and_wait()) {
+            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+        }
+
+        int sent = r.res[Ring::OP];
+        if (sent < 0) {
+            return log_err(file, line, fd, cqe_error(sent, r.timed_out()));
+        } else if (sent == 0) {
+            return log_err(file, line, fd, Error::ConnectionClosed);
+        }
+        i += sent;
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "written " + std::to_string(data.size()) + " bytes"));
+    return Ok();
+}
+
+auto delameta_detail_uring_sendfile(const char* file, int line, int fd, int timeout_ms, int in_fd, size_t n, int64_t offset) -> Result<size_t> {
+    auto start = Clock::now();
+    auto& r = *ring;
+    size_t total = 0;
+
+    // one page less than the pipe holds, so an unaligned file offset still fits in one go
+    const size_t chunk_max = r.pipe_capacity > 4096 ? r.pipe_capacity - 4096 : r.pipe_capacity;
+
+    // move whatever is left in the pipe into the socket, the pipe must be empty between transfers
+    auto drain = [&](size_t left) -> Result<void> {
+        while (left > 0) {
+            auto& sqe = r.prepare(Ring::OP, IORING_OP_SPLICE, fd, timeout_ms >= 0);
+            sqe.splice_fd_in = r.pipe_fd[0];
+            sqe.splice_off_in = -1;
+            sqe.off = -1;
+            sqe.len = left;
+            sqe.splice_flags = SPLICE_F_MOVE;
+            r.prepare_timeout(start, timeout_ms);
+
+            if (not r.submit_and_wait()) {
+                return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+            }
+            if (r.res[Ring::OP] == -EAGAIN) {
+                // splice() into a socket doesn't wait for room in the send buffer, poll for it
+                auto& poll = r.prepare(Ring::OP, IORING_OP_POLL_ADD, fd, timeout_ms >= 0);
+                poll.poll32_events = POLLOUT;
+                r.prepare_timeout(start, timeout_ms);
+
+                if (not r.submit_and_wait()) {
+                    return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+                }
+                if (r.res[Ring::OP] < 0) {
+                    return log_err(file, line, fd, cqe_error(r.res[Ring::OP], r.timed_out()));
+                }
+                continue;
+            }
+            if (r.res[Ring::OP] <= 0) {
+                return log_err(file, line, fd, r.res[Ring::OP] == 0 ? Error::ConnectionClosed : cqe_error(r.res[Ring::OP], r.timed_out()));
+            }
+            left -= r.res[Ring::OP];
+        }
+        return Ok();
+    };
+
+    while (total < n) {
+        size_t chunk = std::min(n - total, chunk_max);
+
+        // file -> pipe -> socket as one linked submission
+        auto& in = r.prepare(Ring::OP, IORING_OP_SPLICE, r.pipe_fd[1], true);
+        in.splice_fd_in = in_fd;
+        in.splice_off_in = offset < 0 ? -1 : offset + total;
+        in.off = -1;
+        in.len = chunk;
+        in.splice_flags = SPLICE_F_MOVE;
+
+        auto& out = r.prepare(Ring::OP2, IORING_OP_SPLICE, fd, timeout_ms >= 0);
+        out.splice_fd_in = r.pipe_fd[0];
+        out.splice_off_in = -1;
+        out.off = -1;
+        out.len = chunk;
+        out.splice_flags = SPLICE_F_MOVE;
+        r.prepare_timeout(start, timeout_ms);
+
+        if (not r.submit_and_wait()) {
+            return log_err(file, line, fd, Error(errno, ::strerror(errno)));
+        }
+
+        int moved_in = r.res[Ring::OP];
+        int moved_out = std::max(r.res[Ring::OP2], 0);
+        if (moved_in < 0) {
+            return log_err(file, line, fd, Error(-moved_in, ::strerror(-moved_in)));
+        } else if (moved_in == 0) {
+            break; // end of file
+        }
+
+        if (r.res[Ring::OP2] < 0 and r.res[Ring::OP2] != -ECANCELED and r.res[Ring::OP2] != -EAGAIN) {
+            // the bytes stuck in the pipe can't be delivered anymore, start over with a fresh one
+            r.reset_pipe();
+            return log_err(file, line, fd, cqe_error(r.res[Ring::OP2], r.timed_out()));
+        }
+
+        // a short read from the file breaks the link and cancels the socket side, and the socket side may stop
+        // early once the send buffer is full. either way the rest is still in the pipe
+        auto [_, err] = drain(moved_in - moved_out);
+        if (err) {
+            r.reset_pipe();
+            return Err(std::move(*err));
+        }
+
+        total += moved_in;
+        start = Clock::now();
+    }
+
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "sent " + std::to_string(total) + " bytes of file"));
+    return Ok(total);
+}
+
+int delameta_detail_uring_accept(int socket, int timeout_ms) {
+    auto& r = *ring;
+
+    r.prepare(Ring::OP, IORING_OP_ACCEPT, socket, true);
+    r.prepare_timeout(std::chrono::milliseconds(timeout_ms));
+
+    if (not r.submit_and_wait()) return -1;
+
+    int res = r.res[Ring::OP];
+    if (res < 0) {
+        errno = res == -ECANCELED ? EWOULDBLOCK : -res;
+        return -1;
+    }
+
+    // the ring may hand out a non-blocking socket, make it behave like one from accept()
+    delameta_detail_set_blocking(res);
+    return res;
+}
+
+#else
+
+bool delameta_detail_uring_enable(const char* file, int line) {
+    static std::once_flag once;
+    std::call_once(once, [file, line]() {
+        WARNING_AT(file, line, "io_uring support is not compiled in, rebuild with DELAMETA_ENABLE_IO_URING");
+    });
+    return false;
+}
+
+void delameta_detail_uring_disable() {}
+
+bool delameta_detail_uring_active() {
+    return false;
+}
+
+auto delameta_detail_uring_read(const char*, int, int, int) -> Result<std::vector<uint8_t>> {
+    return Err("io_uring is not enabled");
+}
+
+auto delameta_detail_uring_read_buffer(const char*, int, int, int) -> Result<Buffer> {
+    return Err("io_uring is not enabled");
+}
+
+auto delameta_detail_uring_read_into(const char*, int, int, int, Deadline, uint8_t*, size_t) -> Result<size_t> {
+    return Err("io_uring is not enabled");
+}
+
+auto delameta_detail_uring_read_until(const char*, int, int, int, size_t) -> Result<std::vector<uint8_t>> {
+    return Err("io_uring is not enabled");
+}
+
+auto delameta_detail_uring_write(const char*, int, int, int, std::string_view) -> Result<void> {
+    return Err("io_uring is not enabled");
+}
+
+auto delameta_detail_uring_sendfile(const char*, int, int, int, int, size_t, int64_t) -> Result<size_t> {
+    return Err("io_uring is not enabled");
+}
+
+int delameta_detail_uring_accept(int, int) {
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif
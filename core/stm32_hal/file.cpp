@@ -41,6 +41,14 @@ auto File::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto File::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto File::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto File::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -49,10 +57,26 @@ auto File::write(std::string_view data) -> Result<void> {
     NOT_IMPLEMENTED
 }
 
+auto File::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto File::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 auto File::file_size() -> size_t {
     return 0;
 }
 
+auto File::stat() -> Result<Stat> {
+    NOT_IMPLEMENTED
+}
+
+auto File::stat(const std::string& filename) -> Result<Stat> {
+    NOT_IMPLEMENTED
+}
+
 auto File::operator<<(Stream& other) -> File& {
     return *this;
 }
@@ -61,4 +85,6 @@ auto File::operator>>(Stream& s) -> File& {
     return *this;
 }
 
+void File::stream_at(std::shared_ptr<File> file, Stream& s, size_t offset, size_t n, std::function<void()> on_error) {}
+
 #pragma GCC diagnostic pop
\ No newline at end of file
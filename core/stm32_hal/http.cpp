@@ -7,3 +7,7 @@ namespace http = delameta::http;
 auto http::Http::Static(const std::string&, const std::string&, bool) -> delameta::Result<void> {
     return Err("Not implemented");
 }
+
+auto http::Http::Static(const std::string&, const std::string&, StaticArgs) -> delameta::Result<void> {
+    return Err("Not implemented");
+}
@@ -158,11 +158,11 @@ static serial_descriptor_t serial_descriptors[] = {
     #endif
 };
 
-Serial::Serial(const char* file, int line, int fd, int timeout)
+Serial::Serial(const char* file, int line, int fd, int timeout_ms)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , fd(fd)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , file(file)
     , line(line) {}
 
@@ -170,7 +170,9 @@ Serial::Serial(Serial&& other)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , fd(std::exchange(other.fd, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
+    , frame_gap_us(other.frame_gap_us)
+    , max_frame(other.max_frame)
     , file(other.file)
     , line(other.line) {}
 
@@ -196,7 +198,7 @@ auto Serial::Open(const char* file, int line, Args args) -> Result<Serial> {
 
         if (found) {
             if (err.code == HAL_OK) {
-                return Ok(Serial(file, line, i, args.timeout));
+                return Ok(Serial(file, line, i, timeout_ms_of(args.timeout, args.timeout_ms)));
             } else {
                 return Err(std::move(err));
             }
@@ -210,7 +212,7 @@ auto Serial::read() -> Result<std::vector<uint8_t>> {
     if (fd < 0 || fd >= (int)std::size(serial_descriptors))
         return Err(Error{-1, "Invalid fd"});
 
-    uint32_t tout = timeout > 0 ? timeout : osWaitForever;
+    uint32_t tout = timeout_ms > 0 ? timeout_ms : osWaitForever;
     return std::visit([&](auto* fd) { return fd->read(tout); }, serial_descriptors[fd]);
 }
 
@@ -218,10 +220,14 @@ auto Serial::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     if (fd < 0 || fd >= (int)std::size(serial_descriptors))
         return Err(Error{-1, "Invalid fd"});
 
-    uint32_t tout = timeout > 0 ? timeout : osWaitForever;
+    uint32_t tout = timeout_ms > 0 ? timeout_ms : osWaitForever;
     return std::visit([&](auto* fd) { return fd->read_until(tout, n); }, serial_descriptors[fd]);
 }
 
+auto Serial::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto Serial::read_as_stream(size_t n) -> Stream {
     Stream s;
 
@@ -246,7 +252,7 @@ auto Serial::write(std::string_view data) -> Result<void> {
     if (fd < 0 || fd >= (int)std::size(serial_descriptors))
         return Err(Error{-1, "Invalid fd"});
 
-    uint32_t tout = timeout > 0 ? timeout : osWaitForever;
+    uint32_t tout = timeout_ms > 0 ? timeout_ms : osWaitForever;
     return std::visit([&](auto* fd) { return fd->write(tout, data); }, serial_descriptors[fd]);
 }
 
@@ -254,7 +260,7 @@ auto Serial::wait_until_ready() -> Result<void> {
     if (fd < 0 || fd >= (int)std::size(serial_descriptors))
         return Err(Error{-1, "Invalid fd"});
 
-    uint32_t tout = timeout > 0 ? timeout : osWaitForever;
+    uint32_t tout = timeout_ms > 0 ? timeout_ms : osWaitForever;
     return std::visit([&](auto* fd) { return fd->wait_until_ready(tout); }, serial_descriptors[fd]);
 }
 
@@ -283,6 +289,11 @@ auto Server<Serial>::start(const char* file, int line, Serial::Args args) -> Res
     return Ok();
 }
 
+auto Server<Serial>::start(const char* file, int line, Serial::Args serial_args, Args) -> Result<void> {
+    // the loop above already handles one frame at a time and writes the responses in order
+    return start(file, line, std::move(serial_args));
+}
+
 void Server<Serial>::stop() {
     if (on_stop) {
         on_stop();
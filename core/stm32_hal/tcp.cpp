@@ -44,16 +44,16 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
 
     return delameta_wizchip_socket_open(Sn_MR_TCP, port, 0).then([&](int sock) {
         ::connect(sock, hint.unwrap().ip, hint.unwrap().port);
-        return TCP(file, line, sock, args.timeout);
+        return TCP(file, line, sock, timeout_ms_of(args.timeout, args.timeout_ms));
     });
 }
 
-TCP::TCP(const char* file, int line, int socket, int timeout) 
+TCP::TCP(const char* file, int line, int socket, int timeout_ms) 
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
     , keep_alive(true)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , max(-1) 
     , file(file)
     , line(line) {}
@@ -63,7 +63,7 @@ TCP::TCP(TCP&& other)
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
     , keep_alive(other.keep_alive)
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , max(other.max) 
     , file(other.file)
     , line(other.line) {}
@@ -86,7 +86,7 @@ auto TCP::read() -> Result<std::vector<uint8_t>> {
 
         size_t len = ::getSn_RX_RSR(socket);
         if (len == 0) {
-            if (timeout > 0 && etl::time::elapsed(start) > etl::time::seconds(timeout)) {
+            if (timeout_ms > 0 && etl::time::elapsed(start) > etl::time::milliseconds(timeout_ms)) {
                 return Err(Error::TransferTimeout);
             }
             etl::time::sleep(10ms);
@@ -126,7 +126,7 @@ auto TCP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
 
         size_t len = ::getSn_RX_RSR(socket);
         if (len == 0) {
-            if (timeout > 0 && etl::time::elapsed(start) > etl::time::seconds(timeout)) {
+            if (timeout_ms > 0 && etl::time::elapsed(start) > etl::time::milliseconds(timeout_ms)) {
                 return Err(Error::TransferTimeout);
             }
             etl::time::sleep(10ms);
@@ -147,6 +147,14 @@ auto TCP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     }
 }
 
+auto TCP::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TCP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto TCP::read_as_stream(size_t n) -> Stream {
     Stream s;
 
@@ -160,7 +168,7 @@ auto TCP::read_as_stream(size_t n) -> Stream {
             total -= n;
             s.again = total > 0;
         } else {
-            warning(file, line, data.unwrap_err().what);
+            WARNING_AT(file, line, data.unwrap_err().what);
         }
 
         return {reinterpret_cast<const char*>(buffer.data()), buffer.size()};
@@ -194,6 +202,14 @@ auto TCP::write(std::string_view data) -> Result<void> {
     return Ok();
 }
 
+auto TCP::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TCP::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
     auto hint = delameta_detail_resolve_domain(args.host);
     if (hint.is_err()) {
@@ -243,7 +259,7 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
             for (int cnt = 1; *is_running; ++cnt) {
                 auto read_result = session->read();
                 if (read_result.is_err()) {
-                    warning(session->file, session->line, read_result.unwrap_err().what);
+                    WARNING_AT(session->file, session->line, read_result.unwrap_err().what);
                     break;
                 }
 
@@ -252,7 +268,7 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
 
                 if (not session->keep_alive) {
                     if (session->max > 0 and cnt >= session->max) {
-                        info(session->file, session->line, "Reached maximum receive: " + std::to_string(session->socket));
+                        INFO_AT(session->file, session->line, "Reached maximum receive: " + std::to_string(session->socket));
                     }
                     break;
                 }
@@ -264,7 +280,7 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
             etl::time::sleep(1ms);
             auto res = ::socket(session->socket, Sn_MR_TCP, port, Sn_MR_ND);
             if (res < 0) {
-                warning(session->file, session->line, "Unable to initialize socket again");
+                WARNING_AT(session->file, session->line, "Unable to initialize socket again");
                 break;
             }
             etl::time::sleep(1ms);
@@ -323,12 +339,12 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
     NOT_IMPLEMENTED
 }
 
-TCP::TCP(const char* file, int line, int socket, int timeout) 
+TCP::TCP(const char* file, int line, int socket, int timeout_ms) 
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
     , keep_alive(true)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , max(-1) 
     , file(file)
     , line(line) {}
@@ -338,7 +354,7 @@ TCP::TCP(TCP&& other)
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
     , keep_alive(other.keep_alive)
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , max(other.max) 
     , file(other.file)
     , line(other.line) {}
@@ -353,6 +369,14 @@ auto TCP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto TCP::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TCP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto TCP::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -361,5 +385,13 @@ auto TCP::write(std::string_view data) -> Result<void> {
     NOT_IMPLEMENTED
 }
 
+auto TCP::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TCP::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 #pragma GCC diagnostic pop
 #endif
@@ -23,8 +23,8 @@ TLS::TLS(TCP&& tcp, void* ssl)
     : TCP(std::move(tcp)) 
     , ssl(ssl) {}
 
-TLS::TLS(const char* file, int line, int socket, int timeout, void* ssl)
-    : TCP(file, line, socket, timeout)
+TLS::TLS(const char* file, int line, int socket, int timeout_ms, void* ssl)
+    : TCP(file, line, socket, timeout_ms)
     , ssl(ssl) {}
 
 TLS::TLS(TLS&& other)
@@ -41,6 +41,14 @@ auto TLS::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TLS::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto TLS::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -49,6 +57,14 @@ auto TLS::write(std::string_view data) -> Result<void> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TLS::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
     NOT_IMPLEMENTED
 }
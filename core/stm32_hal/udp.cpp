@@ -43,15 +43,15 @@ auto UDP::Open(const char* file, int line, Args args) -> Result<UDP> {
     }
 
     return delameta_wizchip_socket_open(Sn_MR_UDP, port, 0).then([&](int sock) {
-        return UDP(file, line, sock, args.timeout, peer);
+        return UDP(file, line, sock, timeout_ms_of(args.timeout, args.timeout_ms), peer);
     });
 }
 
-UDP::UDP(const char* file, int line, int socket, int timeout, void* peer)
+UDP::UDP(const char* file, int line, int socket, int timeout_ms, void* peer)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , peer(peer)
     , file(file)
     , line(line) {}
@@ -60,7 +60,7 @@ UDP::UDP(UDP&& other)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , peer(std::exchange(other.peer, nullptr))
     , file(other.file)
     , line(other.line) {}
@@ -79,7 +79,7 @@ auto UDP::read() -> Result<std::vector<uint8_t>> {
     while (true) {
         size_t len = ::getSn_RX_RSR(socket);
         if (len == 0) {
-            if (timeout > 0 && etl::time::elapsed(start) > etl::time::seconds(timeout)) {
+            if (timeout_ms > 0 && etl::time::elapsed(start) > etl::time::milliseconds(timeout_ms)) {
                 return Err(Error::TransferTimeout);
             }
             etl::time::sleep(10ms);
@@ -113,7 +113,7 @@ auto UDP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     while (true) {
         size_t len = ::getSn_RX_RSR(socket);
         if (len == 0) {
-            if (timeout > 0 && etl::time::elapsed(start) > etl::time::seconds(timeout)) {
+            if (timeout_ms > 0 && etl::time::elapsed(start) > etl::time::milliseconds(timeout_ms)) {
                 return Err(Error::TransferTimeout);
             }
             etl::time::sleep(10ms);
@@ -136,6 +136,10 @@ auto UDP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     }
 }
 
+auto UDP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto UDP::read_as_stream(size_t n) -> Stream {
     Stream s;
 
@@ -149,7 +153,7 @@ auto UDP::read_as_stream(size_t n) -> Stream {
             total -= n;
             s.again = total > 0;
         } else {
-            warning(file, line, data.unwrap_err().what);
+            WARNING_AT(file, line, data.unwrap_err().what);
         }
 
         return {reinterpret_cast<const char*>(buffer.data()), buffer.size()};
@@ -181,7 +185,7 @@ auto UDP::write(std::string_view data) -> Result<void> {
 }
 
 auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
-    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout});
+    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout, args.timeout_ms});
 
     bool is_running {true};
     on_stop = [this, &is_running]() { 
@@ -229,11 +233,11 @@ auto UDP::Open(const char* file, int line, Args args) -> Result<UDP> {
     NOT_IMPLEMENTED
 }
 
-UDP::UDP(const char* file, int line, int socket, int timeout, void* peer)
+UDP::UDP(const char* file, int line, int socket, int timeout_ms, void* peer)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , peer(peer)
     , file(file)
     , line(line) {}
@@ -242,7 +246,7 @@ UDP::UDP(UDP&& other)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , peer(std::exchange(other.peer, nullptr))
     , file(other.file)
     , line(other.line) {}
@@ -257,6 +261,10 @@ auto UDP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto UDP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto UDP::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -3,7 +3,10 @@
 #include <cstring>
 #include <algorithm>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h> // lseek
+#include <io.h> // _get_osfhandle
+#include <windows.h> // ReadFile
 
 #ifndef MAX_HANDLE_SZ
 #define MAX_HANDLE_SZ 128
@@ -20,7 +23,7 @@ using etl::defer;
 static auto log_errno(const char* file, int line) {
     int code = errno;
     std::string what = ::strerror(code);
-    warning(file, line, what);
+    WARNING_AT(file, line, what);
     return Err(Error{code, std::move(what)});
 };
 
@@ -40,7 +43,7 @@ auto File::Open(const char* file, int line, Args args) -> Result<File> {
         __oflag = O_RDWR | O_APPEND | O_CREAT;
     } else {
         Error err = {-1, "Invalid mode. expect `r`, `w`, `wa`, `rw` or `rwa`, given `" + args.mode + "`"};
-        warning(file, line, err.what);
+        WARNING_AT(file, line, err.what);
         return Err(std::move(err));
     }
 
@@ -48,7 +51,7 @@ auto File::Open(const char* file, int line, Args args) -> Result<File> {
     if (fd < 0) {
         return log_errno(file, line);
     } else {
-        info(file, line, delameta_detail_log_format_fd(fd, "created"));
+        INFO_AT(file, line, delameta_detail_log_format_fd(fd, "created"));
         return Ok(File(file, line, fd));
     }
 }
@@ -68,7 +71,7 @@ File::File(File&& other)
 File::~File() {
     if (fd < 0) return;
     ::_close(fd);
-    info(file, line, delameta_detail_log_format_fd(fd, "closed"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "closed"));
     fd = -1;
 }
 
@@ -80,6 +83,14 @@ auto File::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     return delameta_detail_read_until(file, line, fd, nullptr, -1, &delameta_detail_is_fd_alive, false, n);
 }
 
+auto File::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto File::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto File::read_as_stream(size_t n) -> Stream {
     return delameta_detail_read_as_stream(file, line, -1, this, n);
 }
@@ -88,12 +99,45 @@ auto File::write(std::string_view data) -> Result<void> {
     return delameta_detail_write(file, line, fd, nullptr, -1, &delameta_detail_is_fd_alive, false, data);
 }
 
+auto File::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto File::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 auto File::file_size() -> size_t {
     auto res = _filelength(fd);
     if (res < 0) PANIC("_filelength() of fd " + std::to_string(fd) + " is " + std::to_string(res));
     return res;
 }
 
+static auto to_stat(const struct _stat64& st) -> File::Stat {
+    return {
+        .size=static_cast<size_t>(st.st_size),
+        .mtime_ns=int64_t(st.st_mtime) * 1'000'000'000,
+        .id=0,
+    };
+}
+
+auto File::stat() -> Result<Stat> {
+    struct _stat64 st;
+    if (::_fstat64(fd, &st) < 0) {
+        return log_errno(file, line);
+    }
+    return Ok(to_stat(st));
+}
+
+auto File::stat(const std::string& filename) -> Result<Stat> {
+    struct _stat64 st;
+    if (::_stat64(filename.c_str(), &st) < 0) {
+        int code = errno;
+        return Err(Error{code, ::strerror(code)});
+    }
+    return Ok(to_stat(st));
+}
+
 auto File::operator<<(Stream& other) -> File& {
     other >> *this;
     return *this;
@@ -123,3 +167,29 @@ auto File::operator>>(Stream& s) -> File& {
 
     return *this;
 }
+
+void File::stream_at(std::shared_ptr<File> file, Stream& s, size_t offset, size_t n, std::function<void()> on_error) {
+    s << [file=std::move(file), offset, n, on_error=std::move(on_error), buffer=std::vector<uint8_t>{}](Stream& s) mutable -> std::string_view {
+        if (n == 0) return {};
+        buffer.resize(std::min(n, (size_t)MAX_HANDLE_SZ));
+
+        // ReadFile() with an offset doesn't depend on the file pointer that the other readers move too
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(uint64_t(offset) >> 32);
+        DWORD read = 0;
+        auto handle = reinterpret_cast<HANDLE>(::_get_osfhandle(file->fd));
+        if (not ::ReadFile(handle, buffer.data(), static_cast<DWORD>(buffer.size()), &read, &ov) or read == 0) {
+            // the file got shorter or can't be read, the bytes promised to the reader won't come
+            s.again = false;
+            s.failed = true;
+            if (on_error) on_error();
+            return {};
+        }
+
+        offset += read;
+        n -= read;
+        s.again = n > 0;
+        return {reinterpret_cast<const char*>(buffer.data()), static_cast<size_t>(read)};
+    };
+}
@@ -234,36 +234,36 @@ auto delameta_detail_resolve_domain(const std::string& domain, int sock_type, bo
 }
 
 static auto log_err(const char* file, int line, int fd, Error err) {
-    warning(file, line, delameta_detail_log_format_fd(fd, err.what));
+    WARNING_AT(file, line, delameta_detail_log_format_fd(fd, err.what));
     return Err(std::move(err));
 }
 
 static auto log_received_ok(const char* file, size_t line, int fd, std::vector<uint8_t>& res) {
-    info(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(res.size()) + " bytes"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "read " + std::to_string(res.size()) + " bytes"));
     return Ok(std::move(res));
 }
 
 static auto log_sent_ok(const char* file, size_t line, int fd, size_t n) {
-    info(file, line, delameta_detail_log_format_fd(fd, "written " + std::to_string(n) + " bytes"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(fd, "written " + std::to_string(n) + " bytes"));
     return Ok();
 }
 
 [[maybe_unused]] static auto log_err(const char* file, int line, Error err) {
-    warning(file, line, err.what);
+    WARNING_AT(file, line, err.what);
     return Err(std::move(err));
 }
 
 [[maybe_unused]] static auto log_received_ok(const char* file, size_t line, std::vector<uint8_t>& res) {
-    info(file, line, "read " + std::to_string(res.size()) + " bytes");
+    INFO_AT(file, line, "read " + std::to_string(res.size()) + " bytes");
     return Ok(std::move(res));
 }
 
 [[maybe_unused]] static auto log_sent_ok(const char* file, size_t line, size_t n) {
-    info(file, line, "written " + std::to_string(n) + " bytes");
+    INFO_AT(file, line, "written " + std::to_string(n) + " bytes");
     return Ok();
 }
 
-auto delameta_detail_read(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int), bool is_wsa) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_read(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout_ms, bool(*is_alive)(int), bool is_wsa) -> Result<std::vector<uint8_t>> {
     auto start = std::chrono::high_resolution_clock::now();
     u_long bytes_available = 0;
 
@@ -277,7 +277,7 @@ auto delameta_detail_read(const char* file, int line, int fd, [[maybe_unused]] v
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, fd, Error::TransferTimeout);
             }
             std::this_thread::sleep_for(10ms);
@@ -302,7 +302,7 @@ auto delameta_detail_read(const char* file, int line, int fd, [[maybe_unused]] v
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout, void *peer) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout_ms, void *peer) -> Result<std::vector<uint8_t>> {
     auto start = std::chrono::high_resolution_clock::now();
     u_long bytes_available = 0;
 
@@ -312,7 +312,7 @@ auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout, v
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, fd, Error::TransferTimeout);
             }
             std::this_thread::sleep_for(10ms);
@@ -334,10 +334,10 @@ auto delameta_detail_recvfrom(const char* file, int line, int fd, int timeout, v
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int), bool is_wsa, size_t n) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout_ms, bool(*is_alive)(int), bool is_wsa, size_t n) -> Result<std::vector<uint8_t>> {
 #ifndef DELAMETA_DISABLE_OPENSSL
     if (ssl) { // cannot read parsial data
-        return delameta_detail_read(file, line, fd, ssl, timeout, is_alive);
+        return delameta_detail_read(file, line, fd, ssl, timeout_ms, is_alive);
     }
 #endif
 
@@ -354,7 +354,7 @@ auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unus
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, fd, Error::TransferTimeout);
             }
             std::this_thread::sleep_for(10ms);
@@ -388,7 +388,7 @@ auto delameta_detail_read_until(const char* file, int line, int fd, [[maybe_unus
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int timeout, void *peer, size_t n) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int timeout_ms, void *peer, size_t n) -> Result<std::vector<uint8_t>> {
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<uint8_t> buffer(n);
 
@@ -401,7 +401,7 @@ auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int time
         }
 
         if (bytes_available == 0) {
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, fd, Error::TransferTimeout);
             }
             std::this_thread::sleep_for(10ms);
@@ -425,8 +425,8 @@ auto delameta_detail_recvfrom_until(const char* file, int line, int fd, int time
     return log_err(file, line, fd, Error::ConnectionClosed);
 }
 
-auto delameta_detail_read_as_stream(const char*, int, int timeout, Descriptor* self, size_t n) -> Stream {
-    (void)timeout;
+auto delameta_detail_read_as_stream(const char*, int, int timeout_ms, Descriptor* self, size_t n) -> Stream {
+    (void)timeout_ms;
     Stream s;
 
     s << [self, total=n, buffer=std::vector<uint8_t>{}](Stream& s) mutable -> std::string_view {
@@ -448,8 +448,8 @@ auto delameta_detail_read_as_stream(const char*, int, int timeout, Descriptor* s
     return s;
 }
 
-auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout, bool(*is_alive)(int), bool is_wsa, std::string_view data) -> Result<void> {
-    (void)timeout;
+auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]] void* ssl, int timeout_ms, bool(*is_alive)(int), bool is_wsa, std::string_view data) -> Result<void> {
+    (void)timeout_ms;
 #ifndef DELAMETA_DISABLE_OPENSSL
     auto ssl_ = reinterpret_cast<SSL*>(ssl);
 #endif
@@ -501,8 +501,8 @@ auto delameta_detail_write(const char* file, int line, int fd, [[maybe_unused]]
     return log_sent_ok(file, line, fd, total);
 }
 
-auto delameta_detail_sendto(const char* file, int line, int fd, int timeout, void* peer, std::string_view data) -> Result<void> {
-    (void)timeout;
+auto delameta_detail_sendto(const char* file, int line, int fd, int timeout_ms, void* peer, std::string_view data) -> Result<void> {
+    (void)timeout_ms;
     size_t total = 0;
     for (size_t i = 0; i < data.size();) {
         if (!delameta_detail_is_socket_alive(fd)) {
@@ -572,7 +572,7 @@ void delameta_detail_close_socket(int socket) {
     }
 }
 
-auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, int timeout) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, int timeout_ms) -> Result<std::vector<uint8_t>> {
     auto start = std::chrono::high_resolution_clock::now();
     HANDLE hSerial = fd;
 
@@ -587,7 +587,7 @@ auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, i
         // Check if bytes are available to read
         if (status.cbInQue == 0) {
             // Check for timeout
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, Error::TransferTimeout);
             }
 
@@ -611,7 +611,7 @@ auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, i
     return log_err(file, line, Error::ConnectionClosed);
 }
 
-auto delameta_detail_windows_serial_read_until(const char* file, int line, void* fd, int timeout, size_t n) -> Result<std::vector<uint8_t>> {
+auto delameta_detail_windows_serial_read_until(const char* file, int line, void* fd, int timeout_ms, size_t n) -> Result<std::vector<uint8_t>> {
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<uint8_t> buffer(n);
     HANDLE hSerial = fd;
@@ -631,7 +631,7 @@ auto delameta_detail_windows_serial_read_until(const char* file, int line, void*
 
         if (bytes_available == 0) {
             // Check for timeout
-            if (timeout >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::seconds(timeout)) {
+            if (timeout_ms >= 0 && std::chrono::high_resolution_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
                 return log_err(file, line, Error::TransferTimeout);
             }
 
@@ -660,8 +660,8 @@ auto delameta_detail_windows_serial_read_until(const char* file, int line, void*
     return log_err(file, line, Error::ConnectionClosed);
 }
 
-auto delameta_detail_windows_serial_write(const char* file, int line, void* fd, int timeout, std::string_view data) -> Result<void> {
-    (void)timeout;
+auto delameta_detail_windows_serial_write(const char* file, int line, void* fd, int timeout_ms, std::string_view data) -> Result<void> {
+    (void)timeout_ms;
     size_t total = 0;
     HANDLE hSerial = fd;
 
@@ -26,21 +26,21 @@ auto delameta_detail_resolve_domain(
 auto delameta_detail_read(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
+    int timeout_ms, 
     bool(*is_alive)(int),
     bool is_wsa
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
 auto delameta_detail_recvfrom(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void *peer
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
 auto delameta_detail_read_until(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
+    int timeout_ms, 
     bool(*is_alive)(int),
     bool is_wsa,
     size_t n
@@ -48,20 +48,20 @@ auto delameta_detail_read_until(
 
 auto delameta_detail_recvfrom_until(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void *peer, size_t n
 ) -> Project::delameta::Result<std::vector<uint8_t>>;
 
 auto delameta_detail_read_as_stream(
     const char* file, int line, 
-    int timeout, 
+    int timeout_ms, 
     Project::delameta::Descriptor* self, size_t n
 ) -> Project::delameta::Stream;
 
 auto delameta_detail_write(
     const char* file, int line, 
     int fd, void* ssl,
-    int timeout, 
+    int timeout_ms, 
     bool(*is_alive)(int),
     bool is_wsa,
     std::string_view data
@@ -69,7 +69,7 @@ auto delameta_detail_write(
 
 auto delameta_detail_sendto(
     const char* file, int line, 
-    int fd, int timeout, 
+    int fd, int timeout_ms, 
     void* peer, std::string_view data
 ) -> Project::delameta::Result<void>;
 
@@ -82,7 +82,7 @@ namespace Project::delameta {
         template <typename F>
         Error operator()(int code, F err_to_str) const {
             std::string what = err_to_str(code);
-            warning(file, line, what);
+            WARNING_AT(file, line, what);
             return Error{code, std::move(what)};
         }
 
@@ -94,8 +94,8 @@ namespace Project::delameta {
 auto delameta_detail_create_socket(void* hint, const Project::delameta::LogError& log_error) -> Project::delameta::Result<int>;
 void delameta_detail_close_socket(int socket);
 
-auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, int timeout) -> Project::delameta::Result<std::vector<uint8_t>>;
-auto delameta_detail_windows_serial_read_until(const char* file, int line, void* fd, int timeout, size_t n) -> Project::delameta::Result<std::vector<uint8_t>>;
-auto delameta_detail_windows_serial_write(const char* file, int line, void* fd, int timeout, std::string_view data) -> Project::delameta::Result<void>;
+auto delameta_detail_windows_serial_read(const char* file, int line, void* fd, int timeout_ms) -> Project::delameta::Result<std::vector<uint8_t>>;
+auto delameta_detail_windows_serial_read_until(const char* file, int line, void* fd, int timeout_ms, size_t n) -> Project::delameta::Result<std::vector<uint8_t>>;
+auto delameta_detail_windows_serial_write(const char* file, int line, void* fd, int timeout_ms, std::string_view data) -> Project::delameta::Result<void>;
 
 #endif
@@ -4,6 +4,8 @@
 #include <cstring>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
 #include <atomic>
 #include <algorithm>
 
@@ -35,7 +37,7 @@ static Result<int> get_baudrate(const char* file, int line, int baud) {
         case 256000: return Ok(CBR_256000);
         default: {
             std::string what = "baudrate of " + std::to_string(baud) + " is not acceptable";
-            warning(file, line, what);
+            WARNING_AT(file, line, what);
             return Err(Error{-1, what});
         }
     }
@@ -44,7 +46,7 @@ static Result<int> get_baudrate(const char* file, int line, int baud) {
 static auto log_errno(const char* file, int line) {
     int code = errno;
     std::string what = ::strerror(code);
-    warning(file, line, what);
+    WARNING_AT(file, line, what);
     return Err(Error{code, std::move(what)});
 }
 
@@ -84,7 +86,7 @@ auto Serial::Open(const char* file, int line, Args args) -> Result<Serial> {
 
     if (it != handlers.end()) {
         it->second.counter++;
-        return Ok(Serial(file, line, it->first, args.timeout));
+        return Ok(Serial(file, line, it->first, timeout_ms_of(args.timeout, args.timeout_ms)));
     }
 
     // Open serial port (Windows specific)
@@ -127,26 +129,28 @@ auto Serial::Open(const char* file, int line, Args args) -> Result<Serial> {
 
     int fd = ++fd_counter;
     handlers.emplace(fd, FileDescriptorHandler{args.port, hComm, 1});
-    info(file, line, "created serial port");
+    INFO_AT(file, line, "created serial port");
 
-    return Ok(Serial(file, line, fd, args.timeout));
+    return Ok(Serial(file, line, fd, timeout_ms_of(args.timeout, args.timeout_ms)));
 }
 
-Serial::Serial(const char* file, int line, int fd, int timeout) 
+Serial::Serial(const char* file, int line, int fd, int timeout_ms) 
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , fd(fd)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , file(file)
-    , line(line) {}
+    , line(line) { request_timeout_ms = timeout_ms; }
 
 Serial::Serial(Serial&& other) 
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , fd(std::exchange(other.fd, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
+    , frame_gap_us(other.frame_gap_us)
+    , max_frame(other.max_frame)
     , file(other.file)
-    , line(other.line) {}
+    , line(other.line) { request_timeout_ms = other.request_timeout_ms; }
 
 Serial::~Serial() {
     if (fd < 0) return;
@@ -161,24 +165,28 @@ Serial::~Serial() {
     }
 
     handlers.erase(it);
-    info(file, line, "closed");
+    INFO_AT(file, line, "closed");
     fd = -1;
 }
 
 auto Serial::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_windows_serial_read(file, line, handlers.at(fd).fd, timeout);
+    return delameta_detail_windows_serial_read(file, line, handlers.at(fd).fd, timeout_left(timeout_ms, deadline));
 }
 
 auto Serial::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_windows_serial_read_until(file, line, handlers.at(fd).fd, timeout, n);
+    return delameta_detail_windows_serial_read_until(file, line, handlers.at(fd).fd, timeout_left(timeout_ms, deadline), n);
+}
+
+auto Serial::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
 }
 
 auto Serial::write(std::string_view data) -> Result<void> {
-    return delameta_detail_windows_serial_write(file, line, handlers.at(fd).fd, timeout, data);
+    return delameta_detail_windows_serial_write(file, line, handlers.at(fd).fd, timeout_left(timeout_ms, deadline), data);
 }
 
 auto Serial::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto Serial::wait_until_ready() -> Result<void> {
@@ -232,6 +240,96 @@ auto Server<Serial>::start(const char* file, int line, Serial::Args args) -> Res
     return Ok();
 }
 
+auto Server<Serial>::start(const char* file, int line, Serial::Args serial_args, Args args) -> Result<void> {
+    if (args.n_handler <= 0) {
+        return Err("Invalid handler value, must be positive integer");
+    }
+    if (args.max_queue == 0) {
+        return Err("Invalid max queue value, must be positive integer");
+    }
+
+    auto [ser, ser_err] = Serial::Open(file, line, std::move(serial_args));
+    if (ser_err) return Err(std::move(*ser_err));
+
+    const auto name = delameta_detail_get_filename(ser->fd);
+    std::deque<std::pair<uint64_t, std::vector<uint8_t>>> frame_que;
+    uint64_t next_write = 0;
+    std::mutex mtx;
+    std::condition_variable cv_frame; // a frame was queued
+    std::condition_variable cv_space; // a frame was taken from the queue
+    std::condition_variable cv_turn; // a response was written
+    std::atomic_bool is_running {true};
+
+    on_stop = [this, &is_running, &mtx, &cv_frame, &cv_space, &cv_turn]() { 
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            is_running = false;
+        }
+        cv_frame.notify_all();
+        cv_space.notify_all();
+        cv_turn.notify_all();
+        on_stop = {};
+    };
+
+    auto work = [this, &ser, &name, &frame_que, &next_write, &mtx, &cv_frame, &cv_space, &cv_turn, &is_running]() {
+        while (is_running) {
+            std::pair<uint64_t, std::vector<uint8_t>> frame;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv_frame.wait(lock, [&]() { return not is_running or not frame_que.empty(); });
+                if (not is_running) break;
+                frame = std::move(frame_que.front());
+                frame_que.pop_front();
+            }
+            cv_space.notify_one();
+
+            auto& [seq, data] = frame;
+            auto stream = execute_stream_session(*ser, name, data);
+
+            // wait for the responses of the previous frames
+            std::unique_lock<std::mutex> lock(mtx);
+            cv_turn.wait(lock, [&]() { return not is_running or next_write == seq; });
+            if (not is_running) break;
+
+            lock.unlock();
+            stream >> *ser;
+
+            lock.lock();
+            ++next_write;
+            lock.unlock();
+            cv_turn.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(args.n_handler);
+    for (int i = 0; i < args.n_handler; ++i) {
+        threads.emplace_back(work);
+    }
+
+    for (uint64_t seq = 0; is_running and delameta_detail_is_fd_alive(ser->fd);) {
+        ser->wait_until_ready();
+        auto read_result = ser->read();
+        if (read_result.is_err()) {
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv_space.wait(lock, [&]() { return not is_running or frame_que.size() < args.max_queue; });
+            if (not is_running) break;
+            frame_que.emplace_back(seq++, std::move(read_result.unwrap()));
+        }
+        cv_frame.notify_one();
+    }
+
+    stop();
+    for (auto& thd : threads) if (thd.joinable()) {
+        thd.join();
+    }
+    return Ok();
+}
+
 void Server<Serial>::stop() {
     if (on_stop) {
         on_stop();
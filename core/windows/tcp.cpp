@@ -48,7 +48,7 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
         }
 
         ::inet_ntop(hint->ai_family, addr, ip_str, sizeof ip_str);
-        info(__FILE__, __LINE__, "resolved: " + std::string(ip_str));
+        INFO_AT(__FILE__, __LINE__, "resolved: " + std::string(ip_str));
     }
 
     for (auto p = hint; p != nullptr; p = p->ai_next) {
@@ -91,24 +91,25 @@ auto TCP::Open(const char* file, int line, Args args) -> Result<TCP> {
             }
         }
 
-        return Ok(TCP(file, line, socket, args.timeout));
+        return Ok(TCP(file, line, socket, timeout_ms_of(args.timeout, args.timeout_ms)));
     }
 
     return Err(std::move(err));
 }
 
-TCP::TCP(const char* file, int line, int socket, int timeout)
+TCP::TCP(const char* file, int line, int socket, int timeout_ms)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
     , keep_alive(true)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , max(-1) 
     , file(file)
     , line(line)
 {
+    request_timeout_ms = timeout_ms;
     delameta_detail_set_non_blocking(socket);
-    info(file, line, delameta_detail_log_format_fd(socket, "created"));
+    INFO_AT(file, line, delameta_detail_log_format_fd(socket, "created"));
 }
 
 TCP::TCP(TCP&& other)
@@ -116,33 +117,49 @@ TCP::TCP(TCP&& other)
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
     , keep_alive(other.keep_alive)
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , max(other.max) 
     , file(other.file)
-    , line(other.line) {}
+    , line(other.line) { request_timeout_ms = other.request_timeout_ms; }
 
 TCP::~TCP() {
     if (socket >= 0) {
-        info(file, line, delameta_detail_log_format_fd(socket, "closed"));
+        INFO_AT(file, line, delameta_detail_log_format_fd(socket, "closed"));
         delameta_detail_close_socket(socket);
         socket = -1;
     }
 }
 
 auto TCP::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive, true);
+    return delameta_detail_read(file, line, socket, nullptr, timeout_left(timeout_ms, deadline), delameta_detail_is_socket_alive, true);
 }
 
 auto TCP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read_until(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive, true, n);
+    return delameta_detail_read_until(file, line, socket, nullptr, timeout_left(timeout_ms, deadline), delameta_detail_is_socket_alive, true, n);
+}
+
+auto TCP::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TCP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
 }
 
 auto TCP::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto TCP::write(std::string_view data) -> Result<void> {
-    return delameta_detail_write(file, line, socket, nullptr, timeout, delameta_detail_is_socket_alive, true, data);
+    return delameta_detail_write(file, line, socket, nullptr, timeout_left(timeout_ms, deadline), delameta_detail_is_socket_alive, true, data);
+}
+
+auto TCP::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TCP::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
 }
 
 auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
@@ -203,7 +220,7 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
 
         auto wsa_defer = etl::defer | &WSACleanup;
 
-        info(file, line, "Spawned worker thread: " + std::to_string(idx));
+        INFO_AT(file, line, "Spawned worker thread: " + std::to_string(idx));
         while (is_running) {
             int sock_client;
             {
@@ -214,9 +231,9 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
                 client_que.pop_front();
             }
 
-            info(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
+            INFO_AT(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
 
-            TCP session(file, line, sock_client, args.timeout);
+            TCP session(file, line, sock_client, timeout_ms_of(args.timeout, args.timeout_ms));
             session.keep_alive = args.keep_alive;
 
             for (int cnt = 1; is_running and delameta_detail_is_socket_alive(sock_client); ++cnt) {
@@ -230,20 +247,20 @@ auto Server<TCP>::start(const char* file, int line, Args args) -> Result<void> {
 
                 if (not session.keep_alive) {
                     if (session.max > 0 and cnt >= session.max) {
-                        info(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
+                        INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
                     }
                     break;
                 }
 
-                info(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
             }
 
             // shutdown if still connected
             if (delameta_detail_is_socket_alive(session.socket)) {
                 ::shutdown(session.socket, SHUT_RDWR);
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
             } else {
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
             }
 
             {
@@ -22,8 +22,8 @@ TLS::TLS(TCP&& tcp, void* ssl)
     : TCP(std::move(tcp)) 
     , ssl(ssl) {}
 
-TLS::TLS(const char* file, int line, int socket, int timeout, void* ssl)
-    : TCP(file, line, socket, timeout)
+TLS::TLS(const char* file, int line, int socket, int timeout_ms, void* ssl)
+    : TCP(file, line, socket, timeout_ms)
     , ssl(ssl) {}
 
 TLS::TLS(TLS&& other)
@@ -40,6 +40,14 @@ auto TLS::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TLS::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
+}
+
 auto TLS::read_as_stream(size_t n) -> Stream {
     return {};
 }
@@ -48,6 +56,14 @@ auto TLS::write(std::string_view data) -> Result<void> {
     NOT_IMPLEMENTED
 }
 
+auto TLS::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TLS::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
+}
+
 auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
     NOT_IMPLEMENTED
 }
@@ -133,10 +149,18 @@ static void ssl_deinit() {
     }
 }
 
-static auto ssl_handshake(const char* file, int line, int socket, bool as_server) -> Result<SSL*> {
+// gives up with Error::TransferTimeout after `timeout_ms`, or at `deadline` if that is earlier
+static auto ssl_handshake(const char* file, int line, int socket, bool as_server, int timeout_ms, Deadline deadline = {}) -> Result<SSL*> {
     auto [_, err] = ssl_init();
     if (err) return Err(std::move(*err));
 
+    if (timeout_ms >= 0) {
+        deadline = earliest(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+    }
+
+    // a blocking socket would wait inside SSL_accept()/SSL_connect() regardless of the deadline
+    delameta_detail_set_non_blocking(socket);
+
     auto ssl = SSL_new(as_server ? ssl_context_server : ssl_context_client);
     SSL_set_fd(ssl, socket);
 
@@ -149,20 +173,26 @@ static auto ssl_handshake(const char* file, int line, int socket, bool as_server
         int ssl_error = SSL_get_error(ssl, res);
         if (ssl_error == SSL_ERROR_WANT_READ) {
             // Wait for the socket to be ready for reading (use select/poll/epoll)
-            info(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be readable..."));
+            INFO_AT(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be readable..."));
         } else if (ssl_error == SSL_ERROR_WANT_WRITE) {
             // Wait for the socket to be ready for writing
-            info(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be writable..."));
+            INFO_AT(file, line, delameta_detail_log_format_fd(socket, "waiting for socket to be writable..."));
         } else {
-            warning(file, line, delameta_detail_log_format_fd(socket, "SSL handshake failed: " + std::to_string(ssl_error)));
+            WARNING_AT(file, line, delameta_detail_log_format_fd(socket, "SSL handshake failed: " + std::to_string(ssl_error)));
             break;
         }
 
+        if (timeout_left(-1, deadline) == 0) break;
         std::this_thread::sleep_for(10ms);
     }
 
     if (res <= 0) {
+        SSL_free(ssl);
         --ssl_counter;
+        if (deadline != Deadline{} and timeout_left(-1, deadline) == 0) {
+            WARNING_AT(file, line, delameta_detail_log_format_fd(socket, "SSL handshake timed out"));
+            return Err(Error::TransferTimeout);
+        }
         return Err(ssl_get_error());
     }
 
@@ -226,18 +256,19 @@ auto TLS::Open(const char* file, int line, Args args) -> Result<TLS> {
     auto [tcp, tcp_err] = TCP::Open(file, line, TCP::Args{
         .host=args.host, 
         .timeout=args.timeout, 
+        .timeout_ms=args.timeout_ms,
         .connection_timeout=args.connection_timeout
     });
     if (tcp_err) return Err(std::move(*tcp_err));
 
-    delameta_detail_set_blocking(tcp->socket);
-
     auto [_, conf_err] = ssl_context_configure(false, args.cert_file, "");
     if (conf_err) return Err(std::move(*conf_err));
 
-    auto [ssl, ssl_err] = ssl_handshake(file, line, tcp->socket, false);
+    auto [ssl, ssl_err] = ssl_handshake(file, line, tcp->socket, false, timeout_ms_of(args.timeout, args.timeout_ms));
     if (ssl_err) return Err(std::move(*ssl_err));
 
+    delameta_detail_set_blocking(tcp->socket);
+
     --ssl_counter;
     return Ok(TLS(std::move(*tcp), *ssl));
 }
@@ -246,8 +277,8 @@ TLS::TLS(TCP&& tcp, void* ssl)
     : TCP(std::move(tcp)) 
     , ssl(ssl) {}
 
-TLS::TLS(const char* file, int line, int socket, int timeout, void* ssl)
-    : TCP(file, line, socket, timeout)
+TLS::TLS(const char* file, int line, int socket, int timeout_ms, void* ssl)
+    : TCP(file, line, socket, timeout_ms)
     , ssl(ssl) {}
 
 TLS::TLS(TLS&& other)
@@ -262,19 +293,35 @@ TLS::~TLS() {
 }
 
 auto TLS::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read(file, line, socket, ssl, timeout, &is_tls_alive, true);
+    return delameta_detail_read(file, line, socket, ssl, timeout_left(timeout_ms, deadline), &is_tls_alive, true);
 }
 
 auto TLS::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_read_until(file, line, socket, ssl, timeout, &is_tls_alive, true, n);
+    return delameta_detail_read_until(file, line, socket, ssl, timeout_left(timeout_ms, deadline), &is_tls_alive, true, n);
+}
+
+auto TLS::read_buffer() -> Result<Buffer> {
+    return Descriptor::read_buffer();
+}
+
+auto TLS::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
 }
 
 auto TLS::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto TLS::write(std::string_view data) -> Result<void> {
-    return delameta_detail_write(file, line, socket, ssl, timeout, &is_tls_alive, true, data);
+    return delameta_detail_write(file, line, socket, ssl, timeout_left(timeout_ms, deadline), &is_tls_alive, true, data);
+}
+
+auto TLS::writev(const std::string_view* data, size_t n) -> Result<void> {
+    return Descriptor::writev(data, n);
+}
+
+auto TLS::write_from_fd(int fd, size_t n, int64_t offset) -> Result<size_t> {
+    return Descriptor::write_from_fd(fd, n, offset);
 }
 
 auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
@@ -340,7 +387,7 @@ auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
 
         auto wsa_defer = etl::defer | &WSACleanup;
 
-        info(file, line, "Spawned worker thread: " + std::to_string(idx));
+        INFO_AT(file, line, "Spawned worker thread: " + std::to_string(idx));
         while (is_running) {
             int sock_client;
             {
@@ -351,7 +398,7 @@ auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
                 client_que.pop_front();
             }
 
-            auto [ssl, ssl_err] = ssl_handshake(file, line, sock_client, true);
+            auto [ssl, ssl_err] = ssl_handshake(file, line, sock_client, true, timeout_ms_of(args.timeout, args.timeout_ms));
             if (ssl_err) {
                 std::lock_guard<std::mutex> lock(mtx);
                 client_set.erase(sock_client);
@@ -359,9 +406,9 @@ auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
                 continue;
             }
 
-            info(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
+            INFO_AT(file, line, "processing in thread " + std::to_string(idx) + ", socket = " + std::to_string(sock_client));
 
-            TLS session(file, line, sock_client, 1, *ssl);
+            TLS session(file, line, sock_client, timeout_ms_of(args.timeout, args.timeout_ms), *ssl);
             session.keep_alive = args.keep_alive;
 
             for (int cnt = 1; is_running and is_tls_alive(sock_client); ++cnt) {
@@ -375,20 +422,20 @@ auto Server<TLS>::start(const char* file, int line, Args args) -> Result<void> {
 
                 if (not session.keep_alive) {
                     if (session.max > 0 and cnt >= session.max) {
-                        info(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
+                        INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "reached maximum receive"));
                     }
                     break;
                 }
 
-                info(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "kept alive"));
             }
 
             // shutdown if still connected
             if (is_tls_alive(sock_client)) {
                 SSL_shutdown(*ssl);
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by server"));
             } else {
-                info(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
+                INFO_AT(file, line, delameta_detail_log_format_fd(sock_client, "closed by peer"));
             }
 
             {
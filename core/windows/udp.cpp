@@ -40,33 +40,37 @@ auto UDP::Open(const char* file, int line, Args args) -> Result<UDP> {
         return Err(log_error.wsa());
     }
 
-    info(file, line, "Created UDP socket: " + std::to_string(socket));
+    INFO_AT(file, line, "Created UDP socket: " + std::to_string(socket));
 
-    return Ok(UDP(file, line, socket, args.timeout, hint));
+    return Ok(UDP(file, line, socket, timeout_ms_of(args.timeout, args.timeout_ms), hint));
 }
 
-UDP::UDP(const char* file, int line, int socket, int timeout, void* peer)
+UDP::UDP(const char* file, int line, int socket, int timeout_ms, void* peer)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(socket)
-    , timeout(timeout)
+    , timeout_ms(timeout_ms)
     , peer(peer)
     , file(file)
-    , line(line) { delameta_detail_set_non_blocking(socket); }
+    , line(line)
+{
+    request_timeout_ms = timeout_ms;
+    delameta_detail_set_non_blocking(socket);
+}
 
 UDP::UDP(UDP&& other)
     : Descriptor()
     , StreamSessionClient(static_cast<Descriptor&>(*this))
     , socket(std::exchange(other.socket, -1))
-    , timeout(other.timeout)
+    , timeout_ms(other.timeout_ms)
     , peer(std::exchange(other.peer, nullptr))
     , file(other.file)
-    , line(other.line) {}
+    , line(other.line) { request_timeout_ms = other.request_timeout_ms; }
 
 UDP::~UDP() {
     if (socket >= 0) {
         delameta_detail_close_socket(socket);
-        info(file, line, "Closed UDP socket: " + std::to_string(socket));
+        INFO_AT(file, line, "Closed UDP socket: " + std::to_string(socket));
         socket = -1;
     } 
     if (peer) {
@@ -75,23 +79,27 @@ UDP::~UDP() {
 }
 
 auto UDP::read() -> Result<std::vector<uint8_t>> {
-    return delameta_detail_recvfrom(file, line, socket, timeout, peer);
+    return delameta_detail_recvfrom(file, line, socket, timeout_left(timeout_ms, deadline), peer);
 }
 
 auto UDP::read_until(size_t n) -> Result<std::vector<uint8_t>> {
-    return delameta_detail_recvfrom_until(file, line, socket, timeout, peer, n);
+    return delameta_detail_recvfrom_until(file, line, socket, timeout_left(timeout_ms, deadline), peer, n);
+}
+
+auto UDP::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    return Descriptor::read_into(buf, cap, deadline);
 }
 
 auto UDP::read_as_stream(size_t n) -> Stream {
-    return delameta_detail_read_as_stream(file, line, timeout, this, n);
+    return delameta_detail_read_as_stream(file, line, timeout_left(timeout_ms, deadline), this, n);
 }
 
 auto UDP::write(std::string_view data) -> Result<void> {
-    return delameta_detail_sendto(file, line, socket, timeout, peer, data);
+    return delameta_detail_sendto(file, line, socket, timeout_left(timeout_ms, deadline), peer, data);
 }
 
 auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
-    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout});
+    auto [udp, err] = UDP::Open(file, line, {args.host, true, args.timeout, args.timeout_ms});
     if (err) return Err(std::move(*err));
 
     std::list<std::thread> threads;
@@ -115,7 +123,7 @@ auto Server<UDP>::start(const char* file, int line, Args args) -> Result<void> {
         ai->ai_addr = reinterpret_cast<::sockaddr*>(sa_in);
         ai->ai_addrlen = sizeof(sockaddr_in);
 
-        UDP session(file, line, udp->socket, udp->timeout, ai);
+        UDP session(file, line, udp->socket, udp->timeout_ms, ai);
 
         auto read_result = session.read();
         if (read_result.is_err()) {
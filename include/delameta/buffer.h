@@ -0,0 +1,60 @@
+#ifndef PROJECT_DELAMETA_BUFFER_H
+#define PROJECT_DELAMETA_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace Project::delameta {
+
+    // Refcounted byte buffer. The storage comes from a per thread pool and goes back to the pool of whichever
+    // thread drops the last reference, so a steady read loop stops allocating once the pool is warm
+    class Buffer {
+    public:
+        Buffer() = default;
+        ~Buffer() { release(); }
+
+        Buffer(const Buffer& other) : block(other.block) { if (block) ++block->ref; }
+        Buffer(Buffer&& other) noexcept : block(other.block) { other.block = nullptr; }
+
+        Buffer& operator=(const Buffer& other);
+        Buffer& operator=(Buffer&& other) noexcept;
+
+        // take a buffer of `size` bytes from the pool of the calling thread
+        static Buffer acquire(size_t size);
+
+        uint8_t* data() { return block ? block->bytes.data() : nullptr; }
+        const uint8_t* data() const { return block ? block->bytes.data() : nullptr; }
+        size_t size() const { return block ? block->bytes.size() : 0; }
+        bool empty() const { return size() == 0; }
+
+        uint8_t* begin() { return data(); }
+        uint8_t* end() { return data() + size(); }
+        const uint8_t* begin() const { return data(); }
+        const uint8_t* end() const { return data() + size(); }
+
+        void resize(size_t n);
+        size_t use_count() const { return block ? block->ref.load() : 0; }
+
+        operator std::string_view() const { return {reinterpret_cast<const char*>(data()), size()}; }
+
+        // number of free blocks in the pool of the calling thread
+        static size_t pooled();
+
+    private:
+        struct Block {
+            std::atomic<uint32_t> ref;
+            std::vector<uint8_t> bytes;
+        };
+
+        struct Pool;
+        static Pool* pool();
+        void release();
+
+        Block* block = nullptr;
+    };
+}
+
+#endif
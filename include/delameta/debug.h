@@ -2,27 +2,89 @@
 #define PROJECT_DELAMETA_DEBUG_H
 
 #include "etl/result.h"
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
 
+// compile-time log level, 0: info, 1: warning, 2: off. checks against a level below it fold to false
+#ifndef DELAMETA_LOG_LEVEL
+#define DELAMETA_LOG_LEVEL 0
+#endif
+
 namespace Project::delameta {
     void info(const char* file, int line, const std::string& msg);
 
     void warning(const char* file, int line, const std::string& msg);
 
     void panic(const char* file, int line, const std::string& msg);
+
+    enum class LogLevel : int { Info, Warning, Off };
+
+    // runtime log level. warnings only, they are rare and come from error paths. set_log_level(LogLevel::Off) or
+    // DELAMETA_LOG_LEVEL silences them, set_log_level(LogLevel::Info) enables the per-call messages
+    inline std::atomic<int> log_threshold{int(LogLevel::Warning)};
+
+    inline void set_log_level(LogLevel level) { log_threshold.store(int(level), std::memory_order_relaxed); }
+
+    inline LogLevel get_log_level() { return LogLevel(log_threshold.load(std::memory_order_relaxed)); }
+
+    // a single branch, check it before building a message
+    inline bool log_enabled(LogLevel level) {
+        return int(level) >= DELAMETA_LOG_LEVEL and int(level) >= log_threshold.load(std::memory_order_relaxed);
+    }
+
+    // Hands messages over to `sink` on a background thread through a bounded lock-free ring, so the thread that
+    // logs never blocks on the sink. Messages pushed while the ring is full are dropped and counted.
+    // Meant to be called from user defined info() and warning()
+    class AsyncLog {
+    public:
+        using Sink = std::function<void(LogLevel level, const char* file, int line, const std::string& msg)>;
+
+        explicit AsyncLog(Sink sink, size_t capacity = 1024);
+        ~AsyncLog(); // writes what is left
+
+        AsyncLog(const AsyncLog&) = delete;
+        AsyncLog& operator=(const AsyncLog&) = delete;
+
+        // returns false if the message is dropped
+        bool push(LogLevel level, const char* file, int line, std::string msg);
+
+        // blocks until every message pushed before the call has been written
+        void flush();
+
+        uint64_t dropped() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+    };
 }
 
 #define FL __FILE__, __LINE__
-#define INFO(...) Project::delameta::info(__FILE__, __LINE__, __VA_ARGS__)
-#define WARNING(...) Project::delameta::warning(__FILE__, __LINE__, __VA_ARGS__)
+#define INFO(...) \
+    (Project::delameta::log_enabled(Project::delameta::LogLevel::Info) ? \
+        Project::delameta::info(__FILE__, __LINE__, __VA_ARGS__) : void())
+#define WARNING(...) \
+    (Project::delameta::log_enabled(Project::delameta::LogLevel::Warning) ? \
+        Project::delameta::warning(__FILE__, __LINE__, __VA_ARGS__) : void())
 #define PANIC(...) Project::delameta::panic(__FILE__, __LINE__, __VA_ARGS__)
 
+// like INFO and WARNING but logged at `file_` and `line_`, e.g. where the descriptor was opened
+#define INFO_AT(file_, line_, ...) \
+    (Project::delameta::log_enabled(Project::delameta::LogLevel::Info) ? \
+        Project::delameta::info(file_, line_, __VA_ARGS__) : void())
+#define WARNING_AT(file_, line_, ...) \
+    (Project::delameta::log_enabled(Project::delameta::LogLevel::Warning) ? \
+        Project::delameta::warning(file_, line_, __VA_ARGS__) : void())
+
 #ifdef FMT_FORMAT_H_
 // use fmt format
 #define DBG(value) \
     [&]() -> decltype(auto) {\
         auto&& _value = value; \
-        Project::delameta::info(__FILE__, __LINE__, fmt::format("{} = {}", #value, _value)); \
+        if (Project::delameta::log_enabled(Project::delameta::LogLevel::Info)) \
+            Project::delameta::info(__FILE__, __LINE__, fmt::format("{} = {}", #value, _value)); \
         return std::forward<decltype(_value)>(_value); \
     }()
 #else
@@ -30,7 +92,8 @@ namespace Project::delameta {
 #define DBG(value) \
     [&]() -> decltype(auto) {\
         auto&& _value = value; \
-        Project::delameta::info(__FILE__, __LINE__, #value + std::string(" = ") + std::to_string(_value)); \
+        if (Project::delameta::log_enabled(Project::delameta::LogLevel::Info)) \
+            Project::delameta::info(__FILE__, __LINE__, #value + std::string(" = ") + std::to_string(_value)); \
         return std::forward<decltype(_value)>(_value); \
     }()
 #endif
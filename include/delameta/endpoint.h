@@ -19,6 +19,7 @@ namespace Project::delameta {
 
         Result<std::vector<uint8_t>> read() override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
         Stream read_as_stream(size_t n) override;
 
         Result<void> write(std::string_view data) override;
@@ -2,6 +2,7 @@
 #define PROJECT_DELAMETA_FILE_H
 
 #include "delameta/stream.h"
+#include <memory>
 
 namespace Project::delameta {
     
@@ -24,15 +25,36 @@ namespace Project::delameta {
         Result<std::vector<uint8_t>> read() override;
         Stream read_as_stream(size_t n) override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<Buffer> read_buffer() override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
 
         Result<void> write(std::string_view data) override;
+        Result<void> writev(const std::string_view* data, size_t n) override;
+        Result<size_t> write_from_fd(int fd, size_t n, int64_t offset = -1) override;
         using Descriptor::write;
 
         size_t file_size();
 
+        struct Stat {
+            size_t size;
+            int64_t mtime_ns; // last modification
+            uint64_t id; // the file on its device, stays the same while it's written in place. 0 if unknown
+
+            bool operator==(const Stat& other) const { return size == other.size and mtime_ns == other.mtime_ns and id == other.id; }
+            bool operator!=(const Stat& other) const { return not (*this == other); }
+        };
+
+        Result<Stat> stat();
+        static Result<Stat> stat(const std::string& filename);
+
         File& operator<<(Stream& s);
         File& operator>>(Stream& s);
 
+        // like operator>> but streams `n` bytes from `offset` without moving the file position, so one open file can
+        // feed several streams at the same time. `s` keeps `file` open until it's done. if the file ends or fails to
+        // read before `n` bytes, `s` is marked failed and `on_error` is called
+        static void stream_at(std::shared_ptr<File> file, Stream& s, size_t offset, size_t n, std::function<void()> on_error = {});
+
         int fd;
         const char* file;
         int line;
@@ -23,6 +23,9 @@ namespace Project::delameta::http {
 
     struct ArgFormItem { const char* key; };
 
+    // a `{name}` or `{name*}` segment of the route pattern
+    struct ArgPathParam { const char* name; };
+
     struct ArgRequest {};
     struct ArgResponse {};
     struct ArgMethod {};
@@ -3,8 +3,10 @@
 
 #include "delameta/http/request.h"
 #include "delameta/http/response.h"
+#include "delameta/http/router.h"
 #include "delameta/http/arg.h"
 #include "delameta/http/error.h"
+#include "delameta/debug.h"
 #include "delameta/json.h"
 
 namespace Project::delameta::http {
@@ -13,14 +15,6 @@ namespace Project::delameta::http {
     delameta::Result<ResponseReader> request(StreamSessionClient&& session, RequestWriter req);
     delameta::Result<ResponseReader> request(RequestWriter req);
 
-    template <typename R, typename... Args>
-    using Handler = std::function<R(Args..., const RequestReader&, ResponseWriter&)>;
-
-    struct Router {
-        std::vector<const char*> methods;
-        Handler<void> function;
-    };
-
     template <typename T> struct is_handler : std::is_convertible<T, std::function<void(const RequestReader&, ResponseWriter&)>> {};
     template <typename T> static constexpr bool is_handler_v = is_handler<T>::value;
 
@@ -146,14 +140,29 @@ namespace Project::delameta::http {
         PathAndMethods Delete(std::string path) { return route(std::move(path), {"DELETE"}); }
         PathAndMethods Options(std::string path) { return route(std::move(path), {"OPTIONS"}); }
 
+        struct StaticArgs {
+            bool chunked = false;
+            bool mount = false; // one `prefix/{path*}` route resolving the files on each request, instead of a route per file
+            size_t cache_size = 0; // number of files kept open with their size, 0 opens the file on every request
+            int revalidate_ms = 1000; // a cached file is compared with its path at most this often, 0 checks on every request
+            std::string index = "index.html"; // the file served for a directory
+        };
+
+        // without `mount` registers a route for each file under `root`, a file added later needs a restart
         delameta::Result<void> Static(const std::string& prefix, const std::string& root, bool chunked = false);
+        delameta::Result<void> Static(const std::string& prefix, const std::string& root, StaticArgs args);
 
         std::unordered_map<std::string, Handler<std::string>> global_headers;
         std::list<Handler<Result<void>>> preconditions;
         Handler<void, const std::string&> logger = {};
         Handler<void, Error> error_handler = default_error_handler;
-        std::unordered_multimap<std::string, Router> routers;
+        RouteTree routers;
         bool show_response_time = false;
+        // body stream outputs are merged up to this many bytes before they are written, 0 disables.
+        // a chunked body is therefore sent once this many bytes are produced or the stream ends;
+        // a response that streams as it goes sets `res.coalesce = false`, text/event-stream is never merged
+        size_t coalesce_size = 16 * 1024;
+        HeadLimits head_limits = {}; // requests with a larger head are answered with StatusRequestHeaderFieldsTooLarge
 
         void execute(const RequestReader& req, ResponseWriter& res) const;
         std::pair<RequestReader, ResponseWriter> execute(Descriptor& desc) const;
@@ -171,6 +180,14 @@ namespace Project::delameta::http {
             int max_socket = 4;
             bool keep_alive = true;
             int timeout = 1;
+            int timeout_ms = 0; // see Server<TCP>::Args
+            bool event_loop = false; // TCP only, see Server<TCP>::Args
+            int n_shard = 1; // see Server<TCP>::Args
+            bool pin_cpu = false;
+            int max_pending = 0;
+            int max_pending_ms = 1000;
+            int retry_after = 1; // seconds, sent with the 503 response to shed connections
+            bool io_uring = false; // TCP only, see Server<TCP>::Args
         };
         delameta::Result<void> listen(ListenArgs args) const;
 
@@ -253,8 +270,10 @@ namespace Project::delameta::http {
                 }
             };
 
-            // routers.emplace(std::move(path), std::move(methods), std::move(function));
-            routers.insert(std::make_pair(std::move(path), Router{std::move(methods), std::move(function)}));
+            // a route registered by the app itself, a bad pattern is a programming error
+            if (auto res = routers.insert(path, Router{std::move(methods), std::move(function)}); res.is_err()) {
+                PANIC(res.unwrap_err().what);
+            }
             return handler;
         }
 
@@ -414,6 +433,17 @@ namespace Project::delameta::http {
                 return etl::Ok(etl::ref_const(req.url.queries));
         }
 
+        template <typename T> static Result<T>
+        process_arg(const ArgPathParam& arg, const RequestReader& req, ResponseWriter&, Context&) {
+            if (auto value = req.path_param(arg.name)) {
+                // a segment that doesn't convert is a bad request, not a server error
+                auto res = convert_string_into<T>(*value);
+                if (res.is_err()) res.unwrap_err().status = StatusBadRequest;
+                return res;
+            }
+            return etl::Err(Error{StatusInternalServerError, std::string() + "path parameter '" + arg.name + "' is not in the route"});
+        }
+
         template <typename T> static Result<T>
         process_arg(const ArgPath&, const RequestReader& req, ResponseWriter&, Context&) {
             return convert_string_into<T>(req.url.path);
@@ -530,6 +560,7 @@ namespace Project::delameta::http::arg {
     inline Arg arg(const char* name) { return {name}; }
     inline ArgJsonItem json_item(const char* key) { return {key}; }
     inline ArgFormItem form(const char* key) { return {key}; }
+    inline ArgPathParam path_param(const char* name) { return {name}; }
 
     template <typename F>
     auto depends(F&& depends_function) {
@@ -0,0 +1,55 @@
+#ifndef PROJECT_DELAMETA_HTTP_PARSER_H
+#define PROJECT_DELAMETA_HTTP_PARSER_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace Project::delameta::http {
+
+    struct HeadLimits {
+        size_t max_head_size = 16 * 1024; // start line and header lines, in bytes
+        size_t max_header_count = 100;
+    };
+
+    // Finds the end of an HTTP/1.x message head as it arrives. Every call resumes where the previous one stopped,
+    // so a head that comes in many small reads is still scanned once
+    class HeadParser {
+    public:
+        enum State { Partial, Complete, TooLarge, TooManyHeaders };
+
+        explicit HeadParser(HeadLimits limits = {}) : limits(limits) {}
+
+        // `data` is everything received so far, it starts with the data given to the previous calls
+        State feed(std::string_view data);
+
+        State state() const { return state_; }
+
+        // size of the head including the empty line, the body starts here once complete
+        size_t head_size() const { return state_ == Complete ? pos : 0; }
+
+        size_t header_count() const { return lines > 0 ? lines - 1 : 0; }
+
+    private:
+        HeadLimits limits;
+        State state_ = Partial;
+        size_t pos = 0; // bytes scanned
+        size_t line_begin = 0;
+        size_t lines = 0; // complete lines, the start line included
+    };
+
+    // length of the token at the front of `sv`, it ends at the first byte that is not a tchar (RFC 9110, 5.6.2)
+    size_t token_length(std::string_view sv);
+
+    // length of the field value at the front of `sv`, it ends at CR, LF or any other control character except HTAB
+    size_t field_value_length(std::string_view sv);
+
+    // instruction set behind the scanners above, the best one the CPU supports is picked on first use
+    enum class ScanIsa { Scalar, SSE42, AVX2 };
+
+    ScanIsa get_scan_isa();
+
+    // use `isa`, or the best supported one below it. meant for tests and benchmarks
+    void set_scan_isa(ScanIsa isa);
+}
+
+#endif
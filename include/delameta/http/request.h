@@ -1,10 +1,14 @@
 #ifndef PROJECT_DELAMETA_HTTP_REQUEST_H
 #define PROJECT_DELAMETA_HTTP_REQUEST_H
 
+#include <array>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "delameta/stream.h"
 #include "delameta/url.h"
+#include "delameta/http/parser.h"
 
 namespace Project::delameta::http {
 
@@ -19,10 +23,35 @@ namespace Project::delameta::http {
         mutable Stream body_stream = {};
     };
 
+    // path parameters captured by the router. they are offsets into the matched path rather than views, so they stay
+    // valid when the request holding that path is moved
+    struct PathParams {
+        static constexpr size_t capacity = 8;
+
+        struct Span {
+            size_t pos;
+            size_t len;
+
+            std::string_view in(std::string_view path) const { return path.substr(pos, len); }
+        };
+
+        const std::vector<std::string>* names = nullptr;
+        std::array<Span, capacity> spans = {};
+        size_t size = 0;
+
+        // nullptr if there is no parameter named `name`
+        const Span* find(std::string_view name) const {
+            for (size_t i = 0; names != nullptr and i < size and i < names->size(); ++i) {
+                if ((*names)[i] == name) return &spans[i];
+            }
+            return nullptr;
+        }
+    };
+
     struct RequestReader {
         RequestReader() = default;
-        RequestReader(Descriptor& desc, std::vector<uint8_t>& data);
-        RequestReader(Descriptor& desc, std::vector<uint8_t>&& data);
+        RequestReader(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits = {});
+        RequestReader(Descriptor& desc, std::vector<uint8_t>&& data, HeadLimits limits = {});
         operator RequestWriter() const;
 
         std::string_view method;
@@ -31,10 +60,20 @@ namespace Project::delameta::http {
         std::unordered_map<std::string_view, std::string_view> headers = {};
         mutable std::string body = {};
         mutable Stream body_stream = {};
+        int error_status = 0; // non zero if the head is rejected, e.g. StatusRequestHeaderFieldsTooLarge
+        mutable PathParams path_params = {};
+        mutable std::string_view routed_path = {}; // the path of a reroute() while its handler runs, `url.path` if empty
+
+        // the value of the path parameter `name` of the matched route, nullopt if it has none
+        std::optional<std::string_view> path_param(std::string_view name) const {
+            auto span = path_params.find(name);
+            if (span == nullptr) return std::nullopt;
+            return span->in(routed_path.data() != nullptr ? routed_path : std::string_view(url.path));
+        }
 
     private:
         std::vector<uint8_t> data;
-        void parse(Descriptor& desc, std::vector<uint8_t>& data);
+        void parse(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits);
     };
 }
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 #include "delameta/stream.h"
+#include "delameta/http/parser.h"
 
 namespace Project::delameta::http {
 
@@ -16,12 +17,13 @@ namespace Project::delameta::http {
         std::unordered_map<std::string, std::string> headers = {};
         std::string body = {};
         Stream body_stream = {};
+        bool coalesce = true; // set to false when each output of body_stream must be sent as soon as it is produced, e.g. NDJSON or long-poll
     };
 
     struct ResponseReader {
         ResponseReader() = default;
-        ResponseReader(Descriptor& desc, std::vector<uint8_t>& data);
-        ResponseReader(Descriptor& desc, std::vector<uint8_t>&& data);
+        ResponseReader(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits = {});
+        ResponseReader(Descriptor& desc, std::vector<uint8_t>&& data, HeadLimits limits = {});
         operator ResponseWriter() const;
 
         std::string_view version = {};
@@ -33,7 +35,7 @@ namespace Project::delameta::http {
     
     private:
         std::vector<uint8_t> data;
-        void parse(Descriptor& desc, std::vector<uint8_t>& data);
+        void parse(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits);
     };
 
     auto status_to_string(int status) -> std::string;
@@ -0,0 +1,73 @@
+#ifndef PROJECT_DELAMETA_HTTP_ROUTER_H
+#define PROJECT_DELAMETA_HTTP_ROUTER_H
+
+#include "delameta/http/request.h"
+#include "delameta/http/response.h"
+#include "delameta/http/error.h"
+#include <functional>
+#include <memory>
+
+namespace Project::delameta::http {
+
+    template <typename R, typename... Args>
+    using Handler = std::function<R(Args..., const RequestReader&, ResponseWriter&)>;
+
+    // percent-decodes `path` and resolves its "." and ".." segments into a relative path without a leading or doubled '/'.
+    // fails with StatusBadRequest if the path goes above its root or has a NUL or a backslash
+    Result<std::string> normalize_path(std::string_view path);
+
+    // bit of a standard method, 0 for any other method
+    uint32_t method_bit(std::string_view method);
+
+    struct Router {
+        std::vector<const char*> methods;
+        Handler<void> function;
+        uint32_t method_mask = 0; // bits of the standard methods in `methods`
+        std::vector<std::string> params = {}; // names of the path parameters, in order
+
+        bool accepts(std::string_view method, uint32_t bit) const;
+    };
+
+    // Compressed radix tree of route patterns. A pattern is a path where a whole segment can be a parameter
+    // `{name}`, and the last segment can be a wildcard `{name*}` that takes the rest of the path.
+    // Static segments are matched before parameters and parameters before wildcards
+    class RouteTree {
+    public:
+        RouteTree();
+        ~RouteTree();
+
+        RouteTree(RouteTree&&) noexcept;
+        RouteTree& operator=(RouteTree&&) noexcept;
+
+        struct Node;
+
+        // whether `pattern` is well formed and has at most PathParams::capacity parameters
+        static bool is_valid(std::string_view pattern);
+
+        // fails with StatusBadRequest if `pattern` is not valid
+        Result<void> insert(std::string_view pattern, Router router);
+
+        // the routes of the pattern matching `path`, or nullptr. the parameters are written to `params` as offsets
+        // into `path`. it doesn't allocate
+        const std::vector<Router>* find(std::string_view path, PathParams& params) const;
+
+        // the route of `path` that accepts `method` or nullptr, `method_not_allowed` tells if the path matched
+        const Router* find(std::string_view path, std::string_view method, PathParams& params, bool& method_not_allowed) const;
+
+        // whether `pattern` itself is registered, parameters are compared by position not by name.
+        // false for an invalid pattern
+        bool contains(std::string_view pattern) const;
+
+        // removes the routes of `pattern` accepting `method`, or all of them if `method` is empty.
+        // returns the number of removed routes, 0 for an invalid pattern
+        size_t erase(std::string_view pattern, std::string_view method = "");
+
+        size_t size() const { return n_routes; }
+
+    private:
+        std::unique_ptr<Node> root;
+        size_t n_routes = 0;
+    };
+}
+
+#endif
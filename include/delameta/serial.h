@@ -7,7 +7,7 @@ namespace Project::delameta {
     
     class Serial : public Descriptor, public StreamSessionClient {
     protected:
-        Serial(const char* file, int line, int fd, int timeout);
+        Serial(const char* file, int line, int fd, int timeout_ms);
 
     public:
         Serial(Serial&&);
@@ -17,6 +17,9 @@ namespace Project::delameta {
             std::string port;
             int baud = 9600;
             int timeout = -1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
+            float frame_gap = 0; // in character times, > 0 makes read() return exactly one frame ended by that much silence, e.g. 3.5 for Modbus RTU
+            size_t max_frame = 4096; // in bytes, a frame is cut here even if the line doesn't go silent
         };
 
         static Result<Serial> Open(const char* file, int line, Args args);
@@ -25,6 +28,7 @@ namespace Project::delameta {
         Result<std::vector<uint8_t>> read() override;
         Stream read_as_stream(size_t n) override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
 
         Result<void> write(std::string_view data) override;
         using Descriptor::write;
@@ -32,16 +36,31 @@ namespace Project::delameta {
         Result<void> wait_until_ready();
 
         int fd;
-        int timeout;
+        int timeout_ms; // negative never expires
+        int frame_gap_us = 0;
+        size_t max_frame = 4096;
         const char* file;
         int line;
+
+        // the timeout in whole seconds, what the `timeout` member used to hold before it became `timeout_ms`
+        [[deprecated("use timeout_ms")]] int timeout() const { return timeout_ms < 0 ? -1 : (timeout_ms + 999) / 1000; }
+        [[deprecated("use timeout_ms")]] void timeout(int seconds) { timeout_ms = timeout_ms_of(seconds, 0); }
     };
 
     template<>
     class Server<Serial> : public StreamSessionServer {
     public:
+        struct Args {
+            int n_handler = 1; // frames handled concurrently, the responses are still written in the received order
+            size_t max_queue = 8; // received frames waiting for a handler, the reader blocks when it is full
+        };
+
         Result<void> start(const char* file, int line, Serial::Args args);
         Result<void> start(Serial::Args args) { return start("", 0, args); }
+
+        // one reader feeding a bounded queue of `n_handler` handlers, responses are written in order
+        Result<void> start(const char* file, int line, Serial::Args serial_args, Args args);
+        Result<void> start(Serial::Args serial_args, Args args) { return start("", 0, serial_args, args); }
         void stop();
     
     protected:
@@ -3,14 +3,36 @@
 
 #include "delameta/movable.h"
 #include "delameta/error.h"
+#include "delameta/buffer.h"
 #include <vector>
 #include <list>
+#include <deque>
+#include <memory>
+#include <new>
+#include <chrono>
+#include <type_traits>
 #include <functional>
 #include <etl/ref.h>
 
 namespace Project::delameta {
     
     class Stream;
+
+    // the point in time a blocking read gives up. a default constructed deadline stands for the descriptor's own timeout
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    // the earlier of the two, a default constructed deadline counts as none
+    Deadline earliest(Deadline a, Deadline b);
+
+    // what is left of `timeout_ms` before `deadline`, a default constructed deadline leaves it as is. negative never
+    // expires, 0 means the deadline has passed
+    int timeout_left(int timeout_ms, Deadline deadline);
+
+    // the timeout of a descriptor in milliseconds from its args, `timeout_ms` takes precedence over `timeout` in seconds
+    // when it is positive. negative never expires
+    constexpr int timeout_ms_of(int timeout, int timeout_ms) {
+        return timeout_ms > 0 ? timeout_ms : timeout < 0 ? -1 : timeout * 1000;
+    }
     
     class Descriptor : public Movable {
     public:
@@ -24,8 +46,24 @@ namespace Project::delameta {
         virtual Result<std::vector<uint8_t>> read_until(size_t n) = 0;
         virtual Stream read_as_stream(size_t n) = 0;
 
+        // same as read() but the bytes land in a pooled buffer, so a read loop doesn't allocate for every read
+        virtual Result<Buffer> read_buffer();
+
+        // read what is available, at most `cap` bytes, straight into `buf`. returns the number of bytes read, or an
+        // error if the descriptor can't read into a caller buffer
+        virtual Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {});
+
         virtual Result<void> write(std::string_view data) = 0;
 
+        // write the `n` pieces of `data` back to back, in as few calls to the underlying device as it allows
+        virtual Result<void> writev(const std::string_view* data, size_t n);
+
+        // move up to `n` bytes from the current position of `fd` into this descriptor without copying them through
+        // userspace. returns the number of bytes moved, or an error if the descriptor can't do it.
+        // a non negative `offset` reads from there instead and leaves the position of `fd` alone, so several writers
+        // can share one open file
+        virtual Result<size_t> write_from_fd(int fd, size_t n, int64_t offset = -1);
+
         Result<void> write(const std::vector<uint8_t>& data) {
             return write(std::string_view{reinterpret_cast<const char*>(data.data()), data.size()});
         }
@@ -37,6 +75,148 @@ namespace Project::delameta {
         Result<void> write(const char* data) {
             return write(std::string_view(data));
         }
+
+        // while set, blocking calls give up at this point at the latest, whatever their own timeout. see DeadlineScope
+        Deadline deadline = {};
+    };
+
+    // gives every blocking call on `des` one common deadline while it lives, so a request made of several reads and
+    // writes can't take longer than that in total. an earlier deadline that is already set stays
+    class DeadlineScope {
+    public:
+        DeadlineScope(Descriptor& des, Deadline deadline) : des(des), prev(des.deadline) {
+            des.deadline = earliest(prev, deadline);
+        }
+
+        // `timeout_ms` from now, negative leaves the deadline as is
+        DeadlineScope(Descriptor& des, int timeout_ms) : des(des), prev(des.deadline) {
+            if (timeout_ms >= 0) des.deadline = earliest(prev, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+        }
+
+        ~DeadlineScope() { des.deadline = prev; }
+
+        DeadlineScope(const DeadlineScope&) = delete;
+        DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+    private:
+        Descriptor& des;
+        Deadline prev;
+    };
+
+    // move only `std::string_view(Stream&)` callable. a callable of up to `inline_size` bytes is stored in place, a
+    // bigger one takes one allocation like std::function does
+    class StreamRule {
+    public:
+        static constexpr size_t inline_size = 56;
+
+        StreamRule() = default;
+        ~StreamRule() { if (ops) ops->destroy(storage); }
+
+        template <typename F, typename = std::enable_if_t<
+            not std::is_same_v<std::decay_t<F>, StreamRule> and std::is_invocable_r_v<std::string_view, std::decay_t<F>&, Stream&>
+        >>
+        StreamRule(F&& f) : ops(&ops_for<std::decay_t<F>>) {
+            using T = std::decay_t<F>;
+            if constexpr (fits_inline<T>) new (storage) T(std::forward<F>(f));
+            else *reinterpret_cast<T**>(storage) = new T(std::forward<F>(f));
+        }
+
+        StreamRule(StreamRule&& other) noexcept : ops(std::exchange(other.ops, nullptr)) {
+            if (ops) ops->move(storage, other.storage);
+        }
+
+        StreamRule& operator=(StreamRule&& other) noexcept {
+            if (this == &other) return *this;
+            if (ops) ops->destroy(storage);
+            ops = std::exchange(other.ops, nullptr);
+            if (ops) ops->move(storage, other.storage);
+            return *this;
+        }
+
+        std::string_view operator()(Stream& s) { return ops->invoke(storage, s); }
+        explicit operator bool() const { return ops != nullptr; }
+
+    private:
+        struct Ops {
+            std::string_view (*invoke)(void*, Stream&);
+            void (*move)(void* dst, void* src) noexcept; // move constructs `dst` and destroys `src`
+            void (*destroy)(void*) noexcept;
+        };
+
+        template <typename T>
+        static constexpr bool fits_inline = sizeof(T) <= inline_size and alignof(T) <= alignof(std::max_align_t) 
+            and std::is_nothrow_move_constructible_v<T>;
+
+        template <typename T>
+        static T* target(void* p) {
+            if constexpr (fits_inline<T>) return std::launder(reinterpret_cast<T*>(p));
+            else return *reinterpret_cast<T**>(p);
+        }
+
+        template <typename T>
+        static inline const Ops ops_for = {
+            [](void* p, Stream& s) -> std::string_view { return (*target<T>(p))(s); },
+            [](void* dst, void* src) noexcept {
+                if constexpr (fits_inline<T>) {
+                    new (dst) T(std::move(*target<T>(src)));
+                    target<T>(src)->~T();
+                } else {
+                    *reinterpret_cast<T**>(dst) = target<T>(src);
+                }
+            },
+            [](void* p) noexcept {
+                if constexpr (fits_inline<T>) target<T>(p)->~T();
+                else delete target<T>(p);
+            },
+        };
+
+        alignas(std::max_align_t) unsigned char storage[inline_size];
+        const Ops* ops = nullptr;
+    };
+
+    // the rules of a stream in order. the first `inline_capacity` rules live inside the stream, more rules go to an
+    // overflow deque. pushing and popping never moves a queued rule, so the view it returned stays valid until it is
+    // popped. moving the rules relocates the inline ones and destroys a retired one, which invalidates those views
+    class StreamRules {
+    public:
+        static constexpr size_t inline_capacity = 4;
+
+        StreamRules() = default;
+        ~StreamRules() { clear(); }
+
+        StreamRules(StreamRules&& other) noexcept;
+        StreamRules& operator=(StreamRules&& other) noexcept;
+
+        bool empty() const { return size() == 0; }
+        size_t size() const { return tail - head + (overflow ? overflow->size() - retired_in_overflow : 0); }
+
+        StreamRule& front() { return (*this)[0]; }
+        StreamRule& operator[](size_t i) {
+            return head + i < tail ? slots()[head + i] : (*overflow)[i - (tail - head) + retired_in_overflow];
+        }
+
+        void push_back(StreamRule rule);
+        void emplace_back(StreamRule rule) { push_back(std::move(rule)); }
+        void pop_front();
+
+        // like pop_front() but the rule is destroyed only on the next pop or move, so the view it returned stays valid
+        // until then
+        void retire_front();
+
+        // move all rules of `other` behind the rules of this
+        void append(StreamRules&& other);
+        void clear();
+
+    private:
+        StreamRule* slots() { return std::launder(reinterpret_cast<StreamRule*>(storage)); }
+        void release_retired();
+
+        alignas(StreamRule) unsigned char storage[inline_capacity * sizeof(StreamRule)];
+        size_t head = 0;
+        size_t tail = 0;
+        std::unique_ptr<std::deque<StreamRule>> overflow;
+        int retired = -1; // inline slot of the retired rule, if any
+        bool retired_in_overflow = false; // the front of `overflow` is the retired rule
     };
 
     class Stream : public Movable {
@@ -47,10 +227,12 @@ namespace Project::delameta {
         Stream(Stream&&);
         Stream& operator=(Stream&&);
 
-        using Rule = std::function<std::string_view(Stream&)>;
-        std::list<Rule> rules = {};
+        using Rule = StreamRule;
+        StreamRules rules = {};
         std::function<void()> at_destructor;
         bool again = false;
+        bool failed = false; // set by a rule that couldn't produce all the output it promised, what went out is cut short
+        Descriptor* sink = nullptr; // the descriptor this stream is being written into, if any
 
         Stream& operator<<(std::string_view data);
         Stream& operator<<(const char* data);
@@ -70,8 +252,16 @@ namespace Project::delameta {
 
         Result<void> out_with_prefix(Descriptor& des, std::function<Result<void>(std::string_view)> prefix);
         std::vector<uint8_t> pop_once();
+
+        // run the front rule once and hand out its output without copying it. the view stays valid until the next pop
+        // or until the stream is moved
+        std::string_view pop_view();
     };
 
+    // merge the small outputs of `s` into outputs of about `high_water` bytes. the merged bytes go out once they reach
+    // `high_water` or `s` runs out, an output that big by itself is passed through without copying
+    Stream coalesce(Stream& s, size_t high_water = 16 * 1024);
+
     class StreamSessionServer : public Movable {
     public:
         using StreamSessionHandler = std::function<Stream(Descriptor&, const std::string&, std::vector<uint8_t>&)>;
@@ -100,6 +290,7 @@ namespace Project::delameta {
         virtual Result<std::vector<uint8_t>> request(Stream& in_stream);
         Descriptor* desc;
         bool is_dyn;
+        int request_timeout_ms = -1; // the writes and reads of one request share a deadline this far ahead, TCP, UDP and Serial of linux and windows start with their own timeout
     };
 
     template <typename T>
@@ -112,6 +303,7 @@ namespace Project::delameta {
 
         delameta::Result<std::vector<uint8_t>> read() override;
         delameta::Result<std::vector<uint8_t>> read_until(size_t n) override;
+        delameta::Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
         Stream read_as_stream(size_t) override;
         delameta::Result<void> write(std::string_view) override;
 
@@ -8,7 +8,7 @@ namespace Project::delameta {
     class TCP : public Descriptor, public StreamSessionClient {
     protected:
         friend class Server<TCP>;
-        TCP(const char* file, int line, int socket, int timeout);
+        TCP(const char* file, int line, int socket, int timeout_ms);
 
     public:
         TCP(TCP&&);
@@ -17,6 +17,7 @@ namespace Project::delameta {
         struct Args {
             std::string host;
             int timeout = -1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
             int connection_timeout = 5;
         };
 
@@ -25,18 +26,35 @@ namespace Project::delameta {
 
         Result<std::vector<uint8_t>> read() override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<Buffer> read_buffer() override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
         Stream read_as_stream(size_t n) override;
 
         Result<void> write(std::string_view data) override;
+        Result<void> writev(const std::string_view* data, size_t n) override;
+        Result<size_t> write_from_fd(int fd, size_t n, int64_t offset = -1) override;
         using Descriptor::write;
 
         int socket;
         bool keep_alive;
-        int timeout;
+        int timeout_ms; // negative never expires
         int max;
     
         const char* file;
         int line;
+
+        // the timeout in whole seconds, what the `timeout` member used to hold before it became `timeout_ms`
+        [[deprecated("use timeout_ms")]] int timeout() const { return timeout_ms < 0 ? -1 : (timeout_ms + 999) / 1000; }
+        [[deprecated("use timeout_ms")]] void timeout(int seconds) { timeout_ms = timeout_ms_of(seconds, 0); }
+    };
+
+    // counters of the queue between the acceptor and the workers of a running server, summed over all shards.
+    // in event loop mode the queue holds connections that became readable
+    struct ServerQueueStats {
+        size_t depth = 0; // waiting for a worker
+        uint64_t handoffs = 0; // picked up by a worker so far
+        uint64_t wait_ns_total = 0; // time spent in the queue, summed over `handoffs`
+        uint64_t wait_ns_max = 0;
     };
 
     template<>
@@ -47,14 +65,28 @@ namespace Project::delameta {
             int max_socket = 4;
             bool keep_alive = true;
             int timeout = 1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
+            bool event_loop = false; // multiplex connections on epoll loops, `max_socket` becomes the number of workers
+            int n_event_loop = 0; // number of epoll loops per shard in event loop mode, 0 means one per CPU core
+            bool buffer_http = false; // event loop mode: the loop reads a whole HTTP request before it wakes a worker
+            int n_shard = 1; // number of SO_REUSEPORT listen sockets, each with its own accept loop and workers
+            bool pin_cpu = false; // pin the threads of shard `i` to CPU `i`
+            int max_pending = 0; // accepted connections that may wait for a free worker, not used in event loop mode
+            int max_pending_ms = 1000; // how long a pending connection may wait before it is shed
+            std::string overload_response = ""; // written to a shed connection before closing it
+            bool io_uring = false; // do the socket I/O through io_uring (DELAMETA_ENABLE_IO_URING), not used in event loop mode
         };
 
         Result<void> start(const char* file, int line, Args args);
         Result<void> start(Args args) { return start("", 0, args); }
         void stop();
+
+        ServerQueueStats queue_stats() const { return on_queue_stats ? on_queue_stats() : ServerQueueStats{}; }
     
     protected:
+        Result<void> start_event_loop(const char* file, int line, const Args& args, const std::vector<int>& sockets);
         std::function<void()> on_stop;
+        std::function<ServerQueueStats()> on_queue_stats;
     };
 }
 
@@ -9,7 +9,7 @@ namespace Project::delameta {
     protected:
         friend class Server<TLS>;
         TLS(TCP&& tcp, void* ssl);
-        TLS(const char* file, int line, int socket, int timeout, void* ssl);
+        TLS(const char* file, int line, int socket, int timeout_ms, void* ssl);
 
     public:
         TLS(TLS&&);
@@ -19,6 +19,7 @@ namespace Project::delameta {
             std::string host;
             std::string cert_file = "";
             int timeout = -1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
             int connection_timeout = 5;
         };
 
@@ -27,9 +28,13 @@ namespace Project::delameta {
 
         Result<std::vector<uint8_t>> read() override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<Buffer> read_buffer() override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
         Stream read_as_stream(size_t n) override;
 
         Result<void> write(std::string_view data) override;
+        Result<void> writev(const std::string_view* data, size_t n) override;
+        Result<size_t> write_from_fd(int fd, size_t n, int64_t offset = -1) override;
         using Descriptor::write;
 
         void* ssl;
@@ -45,14 +50,22 @@ namespace Project::delameta {
             int max_socket = 4;
             bool keep_alive = true;
             int timeout = 1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
+            int n_shard = 1; // number of SO_REUSEPORT listen sockets, each with its own accept loop and workers
+            bool pin_cpu = false; // pin the threads of shard `i` to CPU `i`
+            int max_pending = 0; // accepted connections that may wait for a free worker
+            int max_pending_ms = 1000; // how long a pending connection may wait before it is closed
         };
 
         Result<void> start(const char* file, int line, Args args);
         Result<void> start(Args args) { return start("", 0, args); }
         void stop();
+
+        ServerQueueStats queue_stats() const { return on_queue_stats ? on_queue_stats() : ServerQueueStats{}; }
     
     protected:
         std::function<void()> on_stop;
+        std::function<ServerQueueStats()> on_queue_stats;
     };
 }
 
@@ -8,7 +8,7 @@ namespace Project::delameta {
     class UDP : public Descriptor, public StreamSessionClient {
     protected:
         friend class Server<UDP>;
-        UDP(const char* file, int line, int socket, int timeout, void* peer);
+        UDP(const char* file, int line, int socket, int timeout_ms, void* peer);
 
     public:
         UDP(UDP&&);
@@ -18,6 +18,7 @@ namespace Project::delameta {
             std::string host;
             bool as_server = false;
             int timeout = -1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
         };
 
         static Result<UDP> Open(const char* file, int line, Args args);
@@ -26,15 +27,20 @@ namespace Project::delameta {
         Result<std::vector<uint8_t>> read() override;
         Stream read_as_stream(size_t n) override;
         Result<std::vector<uint8_t>> read_until(size_t n) override;
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline = {}) override;
 
         Result<void> write(std::string_view data) override;
         using Descriptor::write;
 
         int socket;
-        int timeout;
+        int timeout_ms; // negative never expires
         void* peer;
         const char* file;
         int line;
+
+        // the timeout in whole seconds, what the `timeout` member used to hold before it became `timeout_ms`
+        [[deprecated("use timeout_ms")]] int timeout() const { return timeout_ms < 0 ? -1 : (timeout_ms + 999) / 1000; }
+        [[deprecated("use timeout_ms")]] void timeout(int seconds) { timeout_ms = timeout_ms_of(seconds, 0); }
     };
 
     template<>
@@ -43,6 +49,10 @@ namespace Project::delameta {
         struct Args {
             std::string host;
             int timeout = -1;
+            int timeout_ms = 0; // in milliseconds, takes precedence over `timeout` when positive
+            int n_worker = 0; // fixed worker pool that drains the socket with recvmmsg, 0 means one thread per datagram
+            int batch = 32; // datagrams per recvmmsg/sendmmsg call in worker pool mode
+            size_t max_datagram = 65536; // receive buffer size of each datagram slot in worker pool mode
         };
 
         Result<void> start(const char* file, int line, Args args);
@@ -50,6 +60,7 @@ namespace Project::delameta {
         void stop();
     
     protected:
+        Result<void> start_worker_pool(const char* file, int line, const Args& args, UDP& udp);
         std::function<void()> on_stop;
     };
 }
@@ -2,6 +2,7 @@
 #define PROJECT_DELAMETA_UTILS_H
 
 #include <etl/result.h>
+#include <algorithm>
 #include <string>
 #include <string_view>
 #include <iterator>
@@ -24,9 +25,9 @@ namespace Project::delameta {
     }
 
     template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
-    inline constexpr auto string_dec_into(std::string_view sv) -> etl::Result<uint16_t, const char*> {
+    inline constexpr auto string_dec_into(std::string_view sv) -> etl::Result<T, const char*> {
         T res = 0;
-        int dec_shift = 1;
+        T dec_shift = 1;
 
         for (size_t i = sv.length(); i > 0; --i) {
             int num = char_dec_into_int(sv[i - 1]);
@@ -107,12 +108,8 @@ namespace Project::delameta {
     }
 
     inline constexpr std::string_view string_view_consume_line(std::string_view& sv) {
-        size_t pos = 0;
-        for (; pos < sv.size(); ++pos) {
-            if (sv[pos] == '\n') {
-                break;
-            }
-        }
+        // find() is a memchr at runtime
+        size_t pos = std::min(sv.find('\n'), sv.size());
 
         auto res = sv.substr(0, pos);
         sv = sv.substr(pos);
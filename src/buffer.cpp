@@ -0,0 +1,79 @@
+#include "delameta/buffer.h"
+
+using namespace Project::delameta;
+
+// blocks above this capacity are given back to the allocator instead of being kept around
+static constexpr size_t max_pooled_capacity = 256 * 1024;
+static constexpr size_t max_pooled_blocks = 32;
+
+// the pool of a thread is gone once the thread exits, buffers dropped after that go straight to the allocator
+static thread_local bool pool_destroyed = false;
+
+struct Buffer::Pool {
+    std::vector<Block*> blocks;
+
+    Pool() { blocks.reserve(max_pooled_blocks); }
+
+    ~Pool() {
+        pool_destroyed = true;
+        for (auto block : blocks) delete block;
+    }
+};
+
+auto Buffer::pool() -> Pool* {
+    static thread_local Pool pool;
+    return &pool;
+}
+
+Buffer& Buffer::operator=(const Buffer& other) {
+    if (block == other.block) return *this;
+    release();
+    block = other.block;
+    if (block) ++block->ref;
+    return *this;
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    block = other.block;
+    other.block = nullptr;
+    return *this;
+}
+
+Buffer Buffer::acquire(size_t size) {
+    Buffer res;
+    auto& blocks = pool()->blocks;
+    if (blocks.empty()) {
+        res.block = new Block{{1}, {}};
+    } else {
+        res.block = blocks.back();
+        blocks.pop_back();
+        res.block->ref = 1;
+    }
+    res.block->bytes.resize(size);
+    return res;
+}
+
+void Buffer::resize(size_t n) {
+    if (block) block->bytes.resize(n);
+    else *this = acquire(n);
+}
+
+void Buffer::release() {
+    if (block == nullptr) return;
+    if (--block->ref == 0) {
+        auto blocks = pool_destroyed ? nullptr : &pool()->blocks;
+        if (blocks and blocks->size() < max_pooled_blocks and block->bytes.capacity() <= max_pooled_capacity) {
+            block->bytes.clear();
+            blocks->push_back(block);
+        } else {
+            delete block;
+        }
+    }
+    block = nullptr;
+}
+
+size_t Buffer::pooled() {
+    return pool()->blocks.size();
+}
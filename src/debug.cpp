@@ -0,0 +1,130 @@
+#include "delameta/debug.h"
+
+#if !defined(USE_HAL_DRIVER)
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace Project::delameta;
+
+// Bounded MPSC ring (Vyukov). Producers claim a cell with a CAS and publish it with the sequence number,
+// the writer thread is the only consumer
+struct AsyncLog::Impl {
+    struct Cell {
+        std::atomic<size_t> seq;
+        LogLevel level;
+        const char* file;
+        int line;
+        std::string msg;
+    };
+
+    Sink sink;
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0; // owned by the writer thread
+    std::atomic<size_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+
+    // the writer only sleeps on the condition variable when the ring is empty, producers notify it only then
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> is_running{true};
+    std::thread writer;
+
+    Impl(Sink sink, size_t capacity) : sink(std::move(sink)) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        cells.reset(new Cell[n]);
+        mask = n - 1;
+        for (size_t i = 0; i < n; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+        writer = std::thread([this]() { run(); });
+    }
+
+    bool push(LogLevel level, const char* file, int line, std::string&& msg) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            auto diff = intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos);
+            if (diff == 0 and tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (diff > 0) pos = tail.load(std::memory_order_relaxed);
+        }
+
+        cell->level = level;
+        cell->file = file;
+        cell->line = line;
+        cell->msg = std::move(msg);
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        if (sleeping.load(std::memory_order_acquire)) cv.notify_one();
+        return true;
+    }
+
+    // writes every published cell, returns false if there was none
+    bool drain() {
+        bool any = false;
+        for (;;) {
+            auto& cell = cells[head & mask];
+            if (cell.seq.load(std::memory_order_acquire) != head + 1) break;
+
+            sink(cell.level, cell.file, cell.line, cell.msg);
+            cell.msg.clear();
+            cell.seq.store(head + mask + 1, std::memory_order_release);
+            written.store(++head, std::memory_order_release);
+            any = true;
+        }
+        return any;
+    }
+
+    void run() {
+        while (is_running.load(std::memory_order_acquire)) {
+            if (drain()) continue;
+
+            std::unique_lock lock(mutex);
+            sleeping.store(true, std::memory_order_seq_cst);
+            // a producer may have published between the drain and the flag, the timeout bounds a missed notify
+            if (cells[head & mask].seq.load(std::memory_order_acquire) != head + 1) {
+                cv.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+        drain();
+    }
+
+    ~Impl() {
+        is_running.store(false, std::memory_order_release);
+        cv.notify_one();
+        writer.join();
+    }
+};
+
+AsyncLog::AsyncLog(Sink sink, size_t capacity) : impl(new Impl(std::move(sink), capacity)) {}
+
+AsyncLog::~AsyncLog() = default;
+
+bool AsyncLog::push(LogLevel level, const char* file, int line, std::string msg) {
+    return impl->push(level, file, line, std::move(msg));
+}
+
+void AsyncLog::flush() {
+    auto target = impl->tail.load(std::memory_order_acquire);
+    while (impl->written.load(std::memory_order_acquire) < target) {
+        impl->cv.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+uint64_t AsyncLog::dropped() const {
+    return impl->dropped.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -50,21 +50,31 @@ Endpoint& Endpoint::operator=(Endpoint&& other) {
 
 auto Endpoint::read() -> Result<std::vector<uint8_t>> {
     if (desc == nullptr) return Err(Error{-1, "Null descriptor"});
+    DeadlineScope scope(*desc, deadline);
     return desc->read();
 }
 
 auto Endpoint::read_until(size_t n) -> Result<std::vector<uint8_t>> {
     if (desc == nullptr) return Err(Error{-1, "Null descriptor"});
+    DeadlineScope scope(*desc, deadline);
     return desc->read_until(n);
 }
 
+auto Endpoint::read_into(uint8_t* buf, size_t cap, Deadline deadline) -> Result<size_t> {
+    if (desc == nullptr) return Err(Error{-1, "Null descriptor"});
+    DeadlineScope scope(*desc, Descriptor::deadline);
+    return desc->read_into(buf, cap, deadline);
+}
+
 auto Endpoint::read_as_stream(size_t n) -> Stream {
     if (desc == nullptr) return {};
+    DeadlineScope scope(*desc, deadline);
     return desc->read_as_stream(n);
 }
 
 auto Endpoint::write(std::string_view data) -> Result<void> {
     if (desc == nullptr) return Err(Error{-1, "Null descriptor"});
+    DeadlineScope scope(*desc, deadline);
     return desc->write(data);
 }
 
@@ -221,6 +231,11 @@ Result<Endpoint> EndpointFactorySerial(const char* file, int line, const URL& ur
         args.timeout = std::stoi(it->second);
     } 
 
+    it = uri.queries.find("timeout-ms");
+    if (it != uri.queries.end()) {
+        args.timeout_ms = std::stoi(it->second);
+    } 
+
     args.port = uri.host.size() > 0 ? uri.host : uri.path;
     auto fd = Serial::Open(file, line, std::move(args));
     if (fd.is_err()) {
@@ -238,6 +253,11 @@ Result<Endpoint> EndpointFactoryTCP(const char* file, int line, const URL& uri)
         args.timeout = std::stoi(it->second);
     } 
 
+    it = uri.queries.find("timeout-ms");
+    if (it != uri.queries.end()) {
+        args.timeout_ms = std::stoi(it->second);
+    } 
+
     it = uri.queries.find("connection-timeout");
     if (it != uri.queries.end()) {
         args.connection_timeout = std::stoi(it->second);
@@ -261,6 +281,11 @@ Result<Endpoint> EndpointFactoryUDP(const char* file, int line, const URL& uri)
         args.timeout = std::stoi(it->second);
     } 
 
+    it = uri.queries.find("timeout-ms");
+    if (it != uri.queries.end()) {
+        args.timeout_ms = std::stoi(it->second);
+    } 
+
     it = uri.queries.find("as-server");
     if (it != uri.queries.end()) {
         args.as_server = true;
@@ -9,16 +9,32 @@ Stream http::chunked_encode(Stream& inp) {
 
     auto input = new Stream(std::move(inp));
     s << [input, buffer=std::string()](Stream& s) mutable -> std::string_view {
-        auto data = input->pop_once();
-        buffer.clear();
-        buffer.reserve(6 + data.size() + 2);
+        auto data = input->pop_view();
 
-        buffer += num_to_hex_string(data.size()) + "\r\n";
-        buffer.insert(buffer.end(), data.begin(), data.end());
-        buffer += "\r\n";
+        // no last chunk after a body that was cut short, the peer must not take it as complete
+        if (input->failed) {
+            s.again = false;
+            s.failed = true;
+            return {};
+        }
 
+        auto head = num_to_hex_string(data.size()) + "\r\n";
         s.again = !data.empty();
 
+        // the chunk goes to the sink as is, framed by a gather write
+        if (s.sink) {
+            const std::string_view pieces[] = {head, data, "\r\n"};
+            if (s.sink->writev(pieces, 3).is_err()) s.again = false;
+            return {};
+        }
+
+        buffer.clear();
+        buffer.reserve(head.size() + data.size() + 2);
+
+        buffer += head;
+        buffer += data;
+        buffer += "\r\n";
+
         return buffer;
     };
 
@@ -33,17 +49,33 @@ Stream http::chunked_decode(Descriptor& input) {
     using bytes = std::vector<uint8_t>;
     struct Chunked { std::string_view len, data; };
 
-    static const auto read_one_chunk = [](Descriptor &input, bytes &buffer, size_t &residu) -> std::string_view {
+    // `skip` bytes of the input are dropped before the next chunk header is parsed. if `rest` is given, a chunk that
+    // hasn't fully arrived yet is not buffered, only its buffered part is returned and the rest is left in `rest`
+    static const auto read_one_chunk = [](Descriptor &input, bytes &buffer, size_t &residu, size_t &skip, Stream* rest) -> std::string_view {
         if (residu > 0) {
             buffer.erase(buffer.begin(), buffer.begin() + residu);
+            residu = 0;
         }
 
+        while (buffer.size() < skip) {
+            auto read_result = input.read_buffer();
+            if (read_result.is_err()) {
+                return "";
+            }
+
+            auto &read_data = read_result.unwrap();
+            buffer.insert(buffer.end(), read_data.begin(), read_data.end());
+        }
+
+        buffer.erase(buffer.begin(), buffer.begin() + skip);
+        skip = 0;
+
         auto sv = delameta::string_view_from(buffer);
         size_t len_pos = sv.find("\r\n");
 
         while (true) {
             if (len_pos == std::string::npos) {
-                auto read_result = input.read();
+                auto read_result = input.read_buffer();
                 if (read_result.is_err()) {
                     return "";
                 }
@@ -64,6 +96,16 @@ Stream http::chunked_decode(Descriptor& input) {
             auto len = len_res.unwrap();
             auto total_read = len_pos + 2 + len + 2;
 
+            if (sv.size() < total_read and rest and len > 0) {
+                auto buffered = std::min(len, sv.size() - len_pos - 2);
+                if (buffered < len) {
+                    *rest = input.read_as_stream(len - buffered);
+                    residu = len_pos + 2 + buffered;
+                    skip = 2; // trailing CRLF of this chunk
+                    return sv.substr(len_pos + 2, buffered);
+                }
+            }
+
             if (sv.size() < total_read) {
                 len_pos = std::string::npos; // read again
                 continue;
@@ -74,11 +116,30 @@ Stream http::chunked_decode(Descriptor& input) {
         }
     };
 
-    s << [&input, buffer=std::vector<uint8_t>(), residu=size_t(0)](Stream& s) mutable -> std::string_view {
-        auto res = read_one_chunk(input, buffer, residu);
-        s.again = res != "";
+    auto rest = new Stream();
+    s << [&input, buffer=bytes(), residu=size_t(0), skip=size_t(0), rest, rest_done=false](Stream& s) mutable -> std::string_view {
+        // a finished rule of `rest` is only popped on the next call, the view it returned lives in it
+        if (rest_done) {
+            rest->rules.pop_front();
+            rest_done = false;
+        }
+
+        // the rest of the current chunk goes directly from the input to the sink, e.g. splice() into a file
+        if (not rest->rules.empty()) {
+            rest->again = false;
+            rest->sink = s.sink;
+            auto data = rest->rules.front()(*rest);
+            rest_done = not rest->again;
+            s.again = true;
+            return data;
+        }
+
+        auto res = read_one_chunk(input, buffer, residu, skip, s.sink ? rest : nullptr);
+        s.again = res != "" or not rest->rules.empty();
         return res;
     };
 
+    s.at_destructor = [rest]() { delete rest; };
+
     return s;
 }
@@ -106,48 +106,45 @@ auto http::request(RequestWriter req) -> delameta::Result<ResponseReader> {
 }
 
 auto http::Http::reroute(std::string path, etl::Ref<const RequestReader> req, etl::Ref<ResponseWriter> res) -> Result<void> {
-    auto [begin, end] = routers.equal_range(path);
-
-    for (auto it = begin; it != end; ++it) {
-        auto m = std::find_if(it->second.methods.begin(), it->second.methods.end(), [&](const char* method) {
-            return req->method == method;
-        });
-
-        if (m == it->second.methods.end()) continue;
+    PathParams params;
+    bool method_not_allowed;
+    auto router = routers.find(path, req->method, params, method_not_allowed);
+    if (router == nullptr) {
+        return Err(Error{StatusNotFound, "path " + path + " is not found"});
+    }
 
-        it->second.function(*req, *res);
-        return Ok();
+    // the handler sees the parameters of `path`, the request gets its own back once it returns
+    auto prev_params = std::exchange(req->path_params, params);
+    auto prev_path = std::exchange(req->routed_path, std::string_view(path));
+    auto restore = etl::defer | [&]() {
+        req->path_params = prev_params;
+        req->routed_path = prev_path;
     };
 
-    return Err(Error{StatusNotFound, "path " + path + " is not found"});
+    router->function(*req, *res);
+    return Ok();
 }
 
 void http::Http::execute(const http::RequestReader& req, http::ResponseWriter& res) const {
     auto start = delameta_detail_get_time_stamp();
 
     // TODO: version handling
-    res.version = req.version;
+    res.version = req.version.empty() ? std::string_view("HTTP/1.1") : req.version;
 
     // router handler
-    auto [begin, end] = routers.equal_range(req.url.path);
-    bool handled = false;
-
-    for (auto it = begin; it != end; ++it) {
-        handled = true;
-        auto &router = it->second;
-        auto m = std::find(router.methods.begin(), router.methods.end(), req.method);
-
-        if (m == router.methods.end()) {
-            res.status = StatusMethodNotAllowed;
-            continue; // try next iterator
-        }
+    bool method_not_allowed = false;
+    auto router = req.error_status == 0 ? routers.find(req.url.path, req.method, req.path_params, method_not_allowed) : nullptr;
 
+    if (req.error_status != 0) {
+        error_handler(Error(req.error_status), req, res);
+    } else if (router != nullptr) {
         res.status = StatusOK;
-        router.function(req, res);
-        break;
-    };
-
-    if (not handled) error_handler(Error(StatusNotFound), req, res);
+        router->function(req, res);
+    } else if (method_not_allowed) {
+        res.status = StatusMethodNotAllowed;
+    } else {
+        error_handler(Error(StatusNotFound), req, res);
+    }
 
     if (!res.body.empty() && !res.body_stream.rules.empty()) {
         error_handler(Error{StatusInternalServerError, "Multiple body sources"}, req, res);
@@ -169,6 +166,15 @@ void http::Http::execute(const http::RequestReader& req, http::ResponseWriter& r
     } else if (!res.body.empty()) {
         set_content_length(res.body.size(), false);
     } else if (!res.body_stream.rules.empty()) {
+        auto content_type_it = res.headers.find("Content-Type");
+        if (content_type_it == res.headers.end()) content_type_it = res.headers.find("content-type");
+        bool is_event_stream = content_type_it != res.headers.end() && content_type_it->second.rfind("text/event-stream", 0) == 0;
+
+        // small outputs are merged before they hit the wire, except for events and opted out bodies which must go out as they come
+        if (coalesce_size > 0 && res.coalesce && !is_event_stream) {
+            res.body_stream = delameta::coalesce(res.body_stream, coalesce_size);
+        }
+
         if (!content_length_found) {
             auto transfer_encoding_it = res.headers.find("Transfer-Encoding");
             if (transfer_encoding_it == res.headers.end()) transfer_encoding_it = res.headers.find("transfer-encoding");
@@ -206,7 +212,7 @@ auto http::Http::execute(Descriptor& desc) const -> std::pair<RequestReader, Res
         return {};
     }
 
-    auto req = http::RequestReader(desc, std::move(read_result.unwrap()));
+    auto req = http::RequestReader(desc, std::move(read_result.unwrap()), head_limits);
     auto res = http::ResponseWriter{};
 
     execute(req, res);
@@ -214,7 +220,7 @@ auto http::Http::execute(Descriptor& desc) const -> std::pair<RequestReader, Res
 }
 
 auto http::Http::execute(Descriptor& desc, std::vector<uint8_t>& data) const -> std::pair<RequestReader, ResponseWriter> {
-    auto req = http::RequestReader(desc, data);
+    auto req = http::RequestReader(desc, data, head_limits);
     auto res = http::ResponseWriter{};
 
     execute(req, res);
@@ -259,6 +265,9 @@ void http::Http::bind(StreamSessionServer& server, BindArg is_tcp_server) const
         // handle socket configuration
         if (is_tcp_server.is_tcp_server) {
             if (auto socket = static_cast<TCP*>(&desc); socket) {
+                // the rest of a rejected head is still unread, the connection can't be reused
+                if (req.error_status != 0) socket->keep_alive = false;
+
                 auto it = req.headers.find("Connection");
                 if (it == req.headers.end()) {
                     it = req.headers.find("connection");
@@ -280,7 +289,7 @@ void http::Http::bind(StreamSessionServer& server, BindArg is_tcp_server) const
                     std::string_view value = it->second;
                     auto timeout_idx = value.find("timeout=");
                     if (timeout_idx < value.size()) {
-                        socket->timeout = ::atoi(value.data() + timeout_idx + 9);
+                        socket->timeout_ms = ::atoi(value.data() + timeout_idx + 8) * 1000;
                     }
                     auto max_idx = value.find("max=");
                     if (max_idx < value.size()) {
@@ -291,10 +300,35 @@ void http::Http::bind(StreamSessionServer& server, BindArg is_tcp_server) const
         }
 
         if (logger) logger(name, req, res);
-        return res.dump();
+        auto stream = res.dump();
+
+        // a body cut short leaves the peer waiting for the rest, the connection can't be reused
+        if (is_tcp_server.is_tcp_server) {
+            stream << [socket=static_cast<TCP*>(&desc)](Stream& s) -> std::string_view {
+                if (s.failed) socket->keep_alive = false;
+                return {};
+            };
+        }
+        return stream;
     };
 }
 
+// pre-serialized, it is written by the acceptor thread to connections that cannot be served
+static std::string overload_response(int retry_after) {
+    http::ResponseWriter res;
+    res.version = "HTTP/1.1";
+    res.status = http::StatusServiceUnavailable;
+    res.status_string = http::status_to_string(res.status);
+    res.headers["Retry-After"] = std::to_string(retry_after);
+    res.headers["Content-Length"] = "0";
+    res.headers["Connection"] = "close";
+    res.headers["Server"] = "delameta/" DELAMETA_VERSION;
+
+    std::string data;
+    res.dump() >> [&data](std::string_view chunk) { data += chunk; };
+    return data;
+}
+
 auto http::Http::listen(http::Http::ListenArgs args) const -> delameta::Result<void> {
     if (args.cert_file.empty()) {
         Server<TCP> svr;
@@ -304,7 +338,16 @@ auto http::Http::listen(http::Http::ListenArgs args) const -> delameta::Result<v
             .host=args.host,
             .max_socket=args.max_socket,
             .keep_alive=args.keep_alive,
-            .timeout=args.timeout
+            .timeout=args.timeout,
+            .timeout_ms=args.timeout_ms,
+            .event_loop=args.event_loop,
+            .buffer_http=true,
+            .n_shard=args.n_shard,
+            .pin_cpu=args.pin_cpu,
+            .max_pending=args.max_pending,
+            .max_pending_ms=args.max_pending_ms,
+            .overload_response=overload_response(args.retry_after),
+            .io_uring=args.io_uring,
         });
     } else {
         Server<TLS> svr;
@@ -316,7 +359,12 @@ auto http::Http::listen(http::Http::ListenArgs args) const -> delameta::Result<v
             .key_file=args.key_file,
             .max_socket=args.max_socket,
             .keep_alive=args.keep_alive,
-            .timeout=args.timeout
+            .timeout=args.timeout,
+            .timeout_ms=args.timeout_ms,
+            .n_shard=args.n_shard,
+            .pin_cpu=args.pin_cpu,
+            .max_pending=args.max_pending,
+            .max_pending_ms=args.max_pending_ms,
         });
     }
 }
@@ -0,0 +1,221 @@
+#include "delameta/http/parser.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DELAMETA_HTTP_SCAN_X86 1
+#endif
+
+using namespace Project::delameta;
+
+auto http::HeadParser::feed(std::string_view data) -> State {
+    if (state_ != Partial) return state_;
+
+    // scanning stops at the limit, anything after it can't be part of a valid head
+    auto end = std::min(data.size(), limits.max_head_size);
+
+    while (pos < end) {
+        auto nl = static_cast<const char*>(std::memchr(data.data() + pos, '\n', end - pos));
+        if (nl == nullptr) {
+            pos = end;
+            break;
+        }
+
+        size_t nl_pos = nl - data.data();
+        size_t line_size = nl_pos - line_begin;
+        pos = nl_pos + 1;
+
+        // an empty line ends the head, except in place of the start line
+        if (lines > 0 and (line_size == 0 or (line_size == 1 and data[line_begin] == '\r'))) {
+            return state_ = Complete;
+        }
+
+        line_begin = pos;
+        if (++lines > limits.max_header_count + 1) {
+            return state_ = TooManyHeaders;
+        }
+    }
+
+    if (pos >= limits.max_head_size) {
+        return state_ = TooLarge;
+    }
+
+    return state_;
+}
+
+// tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+static constexpr bool is_tchar(uint8_t c) {
+    return (c >= '0' and c <= '9') or (c >= 'A' and c <= 'Z') or (c >= 'a' and c <= 'z') or
+        (c != 0 and std::string_view("!#$%&'*+-.^_`|~").find(char(c)) != std::string_view::npos);
+}
+
+static constexpr bool is_field_value_char(uint8_t c) {
+    return (c >= 0x20 and c != 0x7f) or c == '\t';
+}
+
+static constexpr auto tchar_table = []() {
+    std::array<bool, 256> table = {};
+    for (int c = 0; c < 256; ++c) table[c] = is_tchar(c);
+    return table;
+}();
+
+static size_t token_length_scalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n and tchar_table[uint8_t(p[i])]) ++i;
+    return i;
+}
+
+static size_t field_value_length_scalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n and is_field_value_char(p[i])) ++i;
+    return i;
+}
+
+#ifdef DELAMETA_HTTP_SCAN_X86
+
+// A byte is a tchar if the bit of its high nibble is set in the entry of its low nibble. Both lookups are a single
+// shuffle, bytes >= 0x80 land on a zero high nibble entry
+static constexpr auto tchar_lo_nibbles = []() {
+    std::array<uint8_t, 16> table = {};
+    for (int c = 0; c < 128; ++c) if (is_tchar(c)) table[c & 0xf] |= 1 << (c >> 4);
+    return table;
+}();
+
+static constexpr std::array<uint8_t, 16> tchar_hi_nibbles = {1, 2, 4, 8, 16, 32, 64, 128};
+
+__attribute__((target("sse4.2")))
+static size_t token_length_sse42(const char* p, size_t n) {
+    const auto lo_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tchar_lo_nibbles.data()));
+    const auto hi_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tchar_hi_nibbles.data()));
+    const auto nibble = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        auto lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(b, nibble));
+        auto hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(b, 4), nibble));
+        auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + token_length_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+static size_t field_value_length_sse42(const char* p, size_t n) {
+    const auto flip = _mm_set1_epi8(char(0x80));
+    const auto space = _mm_set1_epi8(char(0x20 ^ 0x80));
+    const auto tab = _mm_set1_epi8('\t');
+    const auto del = _mm_set1_epi8(0x7f);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        // unsigned b < 0x20 as a signed compare
+        auto ctl = _mm_andnot_si128(_mm_cmpeq_epi8(b, tab), _mm_cmplt_epi8(_mm_xor_si128(b, flip), space));
+        auto mask = _mm_movemask_epi8(_mm_or_si128(ctl, _mm_cmpeq_epi8(b, del)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + field_value_length_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t token_length_avx2(const char* p, size_t n) {
+    const auto lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tchar_lo_nibbles.data())));
+    const auto hi_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tchar_hi_nibbles.data())));
+    const auto nibble = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        auto lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(b, nibble));
+        auto hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(b, 4), nibble));
+        auto mask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    // the tail is legacy SSE code, leave the upper halves clean for it
+    _mm256_zeroupper();
+    return i + token_length_sse42(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t field_value_length_avx2(const char* p, size_t n) {
+    const auto flip = _mm256_set1_epi8(char(0x80));
+    const auto space = _mm256_set1_epi8(char(0x20 ^ 0x80));
+    const auto tab = _mm256_set1_epi8('\t');
+    const auto del = _mm256_set1_epi8(0x7f);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        auto ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(b, tab), _mm256_cmpgt_epi8(space, _mm256_xor_si256(b, flip)));
+        auto mask = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(ctl, _mm256_cmpeq_epi8(b, del))));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    _mm256_zeroupper();
+    return i + field_value_length_sse42(p + i, n - i);
+}
+
+#endif
+
+namespace {
+    struct Scanner {
+        http::ScanIsa isa;
+        size_t (*token_length)(const char*, size_t);
+        size_t (*field_value_length)(const char*, size_t);
+    };
+}
+
+static constexpr Scanner scanners[] = {
+    {http::ScanIsa::Scalar, token_length_scalar, field_value_length_scalar},
+#ifdef DELAMETA_HTTP_SCAN_X86
+    {http::ScanIsa::SSE42, token_length_sse42, field_value_length_sse42},
+    {http::ScanIsa::AVX2, token_length_avx2, field_value_length_avx2},
+#endif
+};
+
+static bool is_supported([[maybe_unused]] http::ScanIsa isa) {
+#ifdef DELAMETA_HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if (isa == http::ScanIsa::AVX2) return __builtin_cpu_supports("avx2");
+    if (isa == http::ScanIsa::SSE42) return __builtin_cpu_supports("sse4.2");
+#endif
+    return isa == http::ScanIsa::Scalar;
+}
+
+static std::atomic<const Scanner*> active_scanner = nullptr;
+
+static const Scanner* pick_scanner(http::ScanIsa isa) {
+    const Scanner* res = &scanners[0];
+    for (auto& scanner : scanners) {
+        if (scanner.isa <= isa and is_supported(scanner.isa)) res = &scanner;
+    }
+    return res;
+}
+
+static const Scanner& scanner() {
+    auto res = active_scanner.load(std::memory_order_relaxed);
+    if (res == nullptr) {
+        res = pick_scanner(http::ScanIsa::AVX2);
+        active_scanner.store(res, std::memory_order_relaxed);
+    }
+    return *res;
+}
+
+size_t http::token_length(std::string_view sv) {
+    return scanner().token_length(sv.data(), sv.size());
+}
+
+size_t http::field_value_length(std::string_view sv) {
+    return scanner().field_value_length(sv.data(), sv.size());
+}
+
+auto http::get_scan_isa() -> ScanIsa {
+    return scanner().isa;
+}
+
+void http::set_scan_isa(ScanIsa isa) {
+    active_scanner.store(pick_scanner(isa), std::memory_order_relaxed);
+}
@@ -1,12 +1,13 @@
 #include "delameta/http/request.h"
+#include "delameta/http/response.h"
 #include "delameta/http/chunked.h"
 #include "delameta/utils.h"
-#include <etl/string_view.h>
 
 using namespace Project;
 using namespace Project::delameta;
 
-void delameta_detail_http_request_response_reader_parse_headers_body(
+// returns false if a header line is malformed, it is skipped
+bool delameta_detail_http_request_response_reader_parse_headers_body(
     std::string_view sv, 
     std::unordered_map<std::string_view, std::string_view>& headers, 
     std::string_view& host_value,
@@ -21,13 +22,20 @@ Stream delameta_detail_http_request_response_reader_dump(
     Stream& body_stream
 );
 
-http::RequestReader::RequestReader(Descriptor& desc, std::vector<uint8_t>& data) : data() { parse(desc, data); }
-http::RequestReader::RequestReader(Descriptor& desc, std::vector<uint8_t>&& data) : data(std::move(data)) { parse(desc, this->data); }
+http::RequestReader::RequestReader(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits) : data() { parse(desc, data, limits); }
+http::RequestReader::RequestReader(Descriptor& desc, std::vector<uint8_t>&& data, HeadLimits limits) : data(std::move(data)) { parse(desc, this->data, limits); }
 
-void http::RequestReader::parse(Descriptor& desc, std::vector<uint8_t>& data) {
+void http::RequestReader::parse(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits) {
     auto sv = std::string_view(reinterpret_cast<const char*>(data.data()), data.size());
-    while (sv.find("\r\n\r\n") == std::string::npos and sv.find("\n\n") == std::string::npos) {
-        auto read_result = desc.read();
+    auto parser = HeadParser(limits);
+
+    for (auto state = parser.feed(sv); state != HeadParser::Complete; state = parser.feed(sv)) {
+        if (state == HeadParser::TooLarge or state == HeadParser::TooManyHeaders) {
+            this->error_status = StatusRequestHeaderFieldsTooLarge;
+            return;
+        }
+
+        auto read_result = desc.read_buffer();
         if (read_result.is_err()) {
             return;
         }
@@ -36,15 +44,28 @@ void http::RequestReader::parse(Descriptor& desc, std::vector<uint8_t>& data) {
         sv = std::string_view(reinterpret_cast<const char*>(data.data()), data.size());
     }
 
+    // request-line = method SP request-target SP HTTP-version
     auto first_line = string_view_consume_line(sv);
-    auto [method, path, version] = etl::string_view(first_line.data(), first_line.size()).split<3>(" ");
+    auto method = first_line.substr(0, token_length(first_line));
+    auto rest = first_line.substr(method.size());
+
+    if (method.empty() or rest.empty() or rest[0] != ' ') {
+        this->error_status = StatusBadRequest;
+        return;
+    }
+
+    rest.remove_prefix(1);
+    auto path = rest.substr(0, rest.find(' '));
+    auto version = rest.substr(std::min(path.size() + 1, rest.size()));
 
-    this->method = std::string_view(method.data(), method.len());
-    this->url = std::string(path.data(), path.len());
-    this->version = std::string_view(version.data(), version.len());
+    this->method = method;
+    this->url = std::string(path);
+    this->version = version;
 
     std::string_view host = "";
-    delameta_detail_http_request_response_reader_parse_headers_body(sv, this->headers, host, desc, this->body_stream);
+    if (not delameta_detail_http_request_response_reader_parse_headers_body(sv, this->headers, host, desc, this->body_stream)) {
+        this->error_status = StatusBadRequest;
+    }
 
     if (not host.empty()) {
         this->url.host = host;
@@ -88,7 +109,7 @@ http::RequestReader::operator RequestWriter() const {
     };
 }
 
-void delameta_detail_http_request_response_reader_parse_headers_body(
+bool delameta_detail_http_request_response_reader_parse_headers_body(
     std::string_view sv,
     std::unordered_map<std::string_view, std::string_view>& headers,
     std::string_view& host_value,
@@ -98,27 +119,39 @@ void delameta_detail_http_request_response_reader_parse_headers_body(
     headers.reserve(16);
     std::string_view content_length_value;
     std::string_view transfer_encoding_value;
+    bool is_valid = true;
 
-    for (;;) {
-        auto line = string_view_consume_line(sv);
-        if (line.empty()) break;
-
-        std::string_view key, value;
-        auto key_end = line.find(':');
+    auto consume_line_end = [&sv]() {
+        if (sv.size() >= 2 and sv[0] == '\r' and sv[1] == '\n') sv.remove_prefix(2);
+        else if (not sv.empty() and sv[0] == '\n') sv.remove_prefix(1);
+        else return false;
+        return true;
+    };
 
-        key = line.substr(0, key_end);
-        if (key_end != std::string::npos) {
-            value = line.substr(key_end + 1);
-        } else {
-            key = line;
-        }
+    auto trim_ows = [](std::string_view& sv) {
+        while (not sv.empty() and (sv.front() == ' ' or sv.front() == '\t')) sv.remove_prefix(1);
+        while (not sv.empty() and (sv.back() == ' ' or sv.back() == '\t')) sv.remove_suffix(1);
+    };
 
-        while (!key.empty() && key.back() == ' ') {
-            key = key.substr(0, key.size() - 1);
+    // field-line = field-name ":" OWS field-value OWS, the name and the value are validated while they are scanned
+    while (not sv.empty() and not consume_line_end()) {
+        auto key = sv.substr(0, http::token_length(sv));
+        sv.remove_prefix(key.size());
+
+        std::string_view value;
+        bool is_field_line = not key.empty() and not sv.empty() and sv[0] == ':';
+        if (is_field_line) {
+            sv.remove_prefix(1);
+            value = sv.substr(0, http::field_value_length(sv));
+            sv.remove_prefix(value.size());
+            trim_ows(value);
         }
 
-        while (!value.empty() && value.front() == ' ') {
-            value = value.substr(1);
+        if (not is_field_line or not consume_line_end()) {
+            // not a field line or a control character in the value, skip to the next line
+            is_valid = false;
+            string_view_consume_line(sv);
+            continue;
         }
 
         if (content_length_value.empty() and (key == "Content-Length" or key == "content-length")) {
@@ -174,8 +207,11 @@ void delameta_detail_http_request_response_reader_parse_headers_body(
     if (transfer_encoding_value == "chunked") {
         auto svd = new ChunkedDescriptor(body, desc);
         body_stream << http::chunked_decode(*svd);
-        body_stream.at_destructor = [svd]() { delete svd; };
-        return;
+        body_stream.at_destructor = [svd, decoder_destructor=std::move(body_stream.at_destructor)]() {
+            if (decoder_destructor) decoder_destructor();
+            delete svd;
+        };
+        return is_valid;
     }
 
     // put the already read body in front of the body stream rules
@@ -188,6 +224,8 @@ void delameta_detail_http_request_response_reader_parse_headers_body(
             body_stream << desc.read_as_stream(content_length - body.size());
         }
     }
+
+    return is_valid;
 }
 
 Stream delameta_detail_http_request_response_reader_dump(
@@ -4,7 +4,8 @@
 using namespace Project;
 using namespace Project::delameta;
 
-void delameta_detail_http_request_response_reader_parse_headers_body(
+// returns false if a header line is malformed, it is skipped
+bool delameta_detail_http_request_response_reader_parse_headers_body(
     std::string_view sv, 
     std::unordered_map<std::string_view, std::string_view>& headers, 
     std::string_view& host_value,
@@ -42,13 +43,21 @@ auto http::ResponseWriter::dump() -> Stream {
     );
 }
 
-http::ResponseReader::ResponseReader(Descriptor& desc, std::vector<uint8_t>& data) : data() { parse(desc, data); }
-http::ResponseReader::ResponseReader(Descriptor& desc, std::vector<uint8_t>&& data) : data(std::move(data)) { parse(desc, this->data); }
+http::ResponseReader::ResponseReader(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits) : data() { parse(desc, data, limits); }
+http::ResponseReader::ResponseReader(Descriptor& desc, std::vector<uint8_t>&& data, HeadLimits limits) : data(std::move(data)) { parse(desc, this->data, limits); }
 
-void http::ResponseReader::parse(Descriptor& desc, std::vector<uint8_t>& data) {
+void http::ResponseReader::parse(Descriptor& desc, std::vector<uint8_t>& data, HeadLimits limits) {
     auto sv = std::string_view(reinterpret_cast<const char*>(data.data()), data.size());
-    while (sv.find("\r\n\r\n") == std::string::npos and sv.find("\n\n") == std::string::npos) {
-        auto read_result = desc.read();
+    auto parser = HeadParser(limits);
+
+    for (auto state = parser.feed(sv); state != HeadParser::Complete; state = parser.feed(sv)) {
+        if (state == HeadParser::TooLarge or state == HeadParser::TooManyHeaders) {
+            this->status = -1;
+            this->status_string = "Response head exceeds the limits";
+            return;
+        }
+
+        auto read_result = desc.read_buffer();
         if (read_result.is_err()) {
             return;
         }
@@ -89,6 +98,7 @@ http::ResponseReader::operator ResponseWriter() const {
         .headers=std::move(headers),
         .body=std::move(body),
         .body_stream=std::move(body_stream),
+        .coalesce=false, // a proxied body is passed on as it arrives
     };
 }
 
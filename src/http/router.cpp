@@ -0,0 +1,293 @@
+#include "delameta/http/router.h"
+#include <algorithm>
+
+using namespace Project;
+using namespace Project::delameta;
+
+struct http::RouteTree::Node {
+    std::string prefix; // static part of the edge leading here
+    std::string indices; // first byte of the prefix of each static child
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param;
+    std::unique_ptr<Node> wildcard;
+
+    std::vector<Router> routes;
+    uint32_t method_mask = 0; // union of the masks of `routes`
+    bool has_other_methods = false; // a route lists a method without a bit
+
+    void update_methods() {
+        method_mask = 0;
+        has_other_methods = false;
+        for (auto& route : routes) {
+            method_mask |= route.method_mask;
+            for (auto method : route.methods) {
+                if (method_bit(method) == 0) has_other_methods = true;
+            }
+        }
+    }
+};
+
+uint32_t http::method_bit(std::string_view method) {
+    static constexpr std::string_view methods[] = {
+        "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"
+    };
+    for (size_t i = 0; i < std::size(methods); ++i) {
+        if (methods[i] == method) return 1u << i;
+    }
+    return 0;
+}
+
+static int hex_to_int(char c) {
+    if (c >= '0' and c <= '9') return c - '0';
+    if (c >= 'a' and c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' and c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+auto http::normalize_path(std::string_view path) -> Result<std::string> {
+    std::string res;
+    res.reserve(path.size());
+
+    // decoded before the dot segments are resolved, so "%2e%2e" is a ".." too
+    std::string decoded;
+    decoded.reserve(path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        char c = path[i];
+        if (c == '%' and i + 2 < path.size() and hex_to_int(path[i + 1]) >= 0 and hex_to_int(path[i + 2]) >= 0) {
+            c = static_cast<char>(hex_to_int(path[i + 1]) << 4 | hex_to_int(path[i + 2]));
+            i += 2;
+        }
+        if (c == '\0' or c == '\\') {
+            return etl::Err(Error{StatusBadRequest, "Invalid path"});
+        }
+        decoded += c;
+    }
+
+    std::string_view sv = decoded;
+    while (not sv.empty()) {
+        auto segment = sv.substr(0, sv.find('/'));
+        sv.remove_prefix(std::min(segment.size() + 1, sv.size()));
+
+        if (segment.empty() or segment == ".") continue;
+        if (segment == "..") {
+            if (res.empty()) return etl::Err(Error{StatusBadRequest, "Invalid path"});
+            auto slash = res.rfind('/');
+            res.erase(slash == std::string::npos ? 0 : slash);
+            continue;
+        }
+
+        if (not res.empty()) res += '/';
+        res += segment;
+    }
+
+    return etl::Ok(std::move(res));
+}
+
+bool http::Router::accepts(std::string_view method, uint32_t bit) const {
+    if (bit & method_mask) return true;
+    return std::find(methods.begin(), methods.end(), method) != methods.end();
+}
+
+http::RouteTree::RouteTree() : root(new Node()) {}
+http::RouteTree::~RouteTree() = default;
+
+http::RouteTree::RouteTree(RouteTree&&) noexcept = default;
+http::RouteTree& http::RouteTree::operator=(RouteTree&&) noexcept = default;
+
+using Node = http::RouteTree::Node;
+
+// walks down the static edges of `s`, splitting an edge where `s` leaves it
+static Node* insert_static(Node* node, std::string_view s) {
+    while (not s.empty()) {
+        auto i = node->indices.find(s[0]);
+        if (i == std::string::npos) {
+            node->indices += s[0];
+            node->children.emplace_back(new Node());
+            node->children.back()->prefix = s;
+            return node->children.back().get();
+        }
+
+        auto child = node->children[i].get();
+        auto [s_end, _] = std::mismatch(s.begin(), s.end(), child->prefix.begin(), child->prefix.end());
+        size_t common = s_end - s.begin();
+
+        if (common < child->prefix.size()) {
+            auto split = std::make_unique<Node>();
+            split->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            split->indices += child->prefix[0];
+            split->children.push_back(std::move(node->children[i]));
+            node->children[i] = std::move(split);
+            child = node->children[i].get();
+        }
+
+        node = child;
+        s.remove_prefix(common);
+    }
+    return node;
+}
+
+static const Node* find_static(const Node* node, std::string_view s) {
+    while (node != nullptr and not s.empty()) {
+        auto i = node->indices.find(s[0]);
+        if (i == std::string::npos) return nullptr;
+
+        auto child = node->children[i].get();
+        if (s.substr(0, child->prefix.size()) != child->prefix) return nullptr;
+
+        node = child;
+        s.remove_prefix(child->prefix.size());
+    }
+    return node;
+}
+
+bool http::RouteTree::is_valid(std::string_view pattern) {
+    size_t n_params = 0;
+    for (size_t brace = pattern.find('{'); brace != std::string::npos; brace = pattern.find('{', brace + 1)) {
+        auto close = pattern.find('}', brace);
+        if (close == std::string::npos or (brace > 0 and pattern[brace - 1] != '/')) return false;
+
+        auto name = pattern.substr(brace + 1, close - brace - 1);
+        bool is_wildcard = not name.empty() and name.back() == '*';
+        if (is_wildcard) name.remove_suffix(1);
+
+        size_t next = close + 1;
+        if (name.empty() or name.find('{') != std::string::npos) return false;
+        if (next < pattern.size() and (is_wildcard or pattern[next] != '/')) return false;
+        ++n_params;
+    }
+    return n_params <= PathParams::capacity;
+}
+
+// calls `on_static(node, text)` and `on_param(node, name, is_wildcard)` for each part of the pattern in order,
+// the callbacks return the next node. `pattern` must be valid
+template <typename S, typename P>
+static auto walk_pattern(std::string_view pattern, Node* node, S&& on_static, P&& on_param) -> Node* {
+    size_t pos = 0;
+    while (node != nullptr and pos < pattern.size()) {
+        auto brace = pattern.find('{', pos);
+        node = on_static(node, pattern.substr(pos, brace - pos));
+        if (node == nullptr or brace == std::string::npos) break;
+
+        auto close = pattern.find('}', brace);
+        auto name = pattern.substr(brace + 1, close - brace - 1);
+        pos = close + 1;
+        bool is_wildcard = name.back() == '*';
+        if (is_wildcard) name.remove_suffix(1);
+
+        node = on_param(node, name, is_wildcard);
+    }
+    return node;
+}
+
+auto http::RouteTree::insert(std::string_view pattern, Router router) -> Result<void> {
+    if (not is_valid(pattern)) {
+        return etl::Err(Error{StatusBadRequest, "Invalid route pattern: " + std::string(pattern)});
+    }
+
+    std::vector<std::string> params;
+
+    auto node = walk_pattern(pattern, root.get(), insert_static, [&params](Node* node, std::string_view name, bool is_wildcard) {
+        params.emplace_back(name);
+        auto& next = is_wildcard ? node->wildcard : node->param;
+        if (next == nullptr) next.reset(new Node());
+        return next.get();
+    });
+
+    router.method_mask = 0;
+    for (auto method : router.methods) router.method_mask |= method_bit(method);
+    router.params = std::move(params);
+
+    node->routes.push_back(std::move(router));
+    node->update_methods();
+    ++n_routes;
+    return etl::Ok();
+}
+
+// static edges first, then a parameter, then a wildcard. backtracks when a branch has no route.
+// `path` is what is left of `full`, the parameters are recorded as offsets into `full`
+static const Node* match(const Node* node, std::string_view full, std::string_view path, http::PathParams& params) {
+    if (path.empty() and not node->routes.empty()) return node;
+
+    if (not path.empty()) {
+        if (auto i = node->indices.find(path[0]); i != std::string::npos) {
+            auto child = node->children[i].get();
+            if (path.compare(0, child->prefix.size(), child->prefix) == 0) {
+                if (auto res = match(child, full, path.substr(child->prefix.size()), params)) return res;
+            }
+        }
+
+        if (node->param != nullptr and path[0] != '/') {
+            auto segment = path.substr(0, path.find('/'));
+            params.spans[params.size++] = {size_t(segment.data() - full.data()), segment.size()};
+            if (auto res = match(node->param.get(), full, path.substr(segment.size()), params)) return res;
+            --params.size;
+        }
+    }
+
+    if (node->wildcard != nullptr and not node->wildcard->routes.empty()) {
+        params.spans[params.size++] = {size_t(path.data() - full.data()), path.size()};
+        return node->wildcard.get();
+    }
+
+    return nullptr;
+}
+
+auto http::RouteTree::find(std::string_view path, PathParams& params) const -> const std::vector<Router>* {
+    params.size = 0;
+    params.names = nullptr;
+    auto node = match(root.get(), path, path, params);
+    return node ? &node->routes : nullptr;
+}
+
+auto http::RouteTree::find(std::string_view path, std::string_view method, PathParams& params, bool& method_not_allowed) const -> const Router* {
+    params.size = 0;
+    params.names = nullptr;
+    method_not_allowed = false;
+
+    auto node = match(root.get(), path, path, params);
+    if (node == nullptr) return nullptr;
+
+    auto bit = method_bit(method);
+    if (bit & node->method_mask or node->has_other_methods) {
+        for (auto& route : node->routes) {
+            if (not route.accepts(method, bit)) continue;
+            params.names = &route.params;
+            return &route;
+        }
+    }
+
+    method_not_allowed = true;
+    return nullptr;
+}
+
+static const Node* locate(std::string_view pattern, const Node* root) {
+    return walk_pattern(pattern, const_cast<Node*>(root), [](Node* node, std::string_view s) {
+        return const_cast<Node*>(find_static(node, s));
+    }, [](Node* node, std::string_view, bool is_wildcard) {
+        return is_wildcard ? node->wildcard.get() : node->param.get();
+    });
+}
+
+bool http::RouteTree::contains(std::string_view pattern) const {
+    if (not is_valid(pattern)) return false;
+    auto node = locate(pattern, root.get());
+    return node != nullptr and not node->routes.empty();
+}
+
+size_t http::RouteTree::erase(std::string_view pattern, std::string_view method) {
+    if (not is_valid(pattern)) return 0;
+    auto node = const_cast<Node*>(locate(pattern, root.get()));
+    if (node == nullptr) return 0;
+
+    auto bit = method_bit(method);
+    auto it = std::remove_if(node->routes.begin(), node->routes.end(), [&](const Router& route) {
+        return method.empty() or route.accepts(method, bit);
+    });
+
+    size_t n = node->routes.end() - it;
+    node->routes.erase(it, node->routes.end());
+    node->update_methods();
+    n_routes -= n;
+    return n;
+}
@@ -2,6 +2,9 @@
 #include "delameta/debug.h"
 #include "delameta/utils.h"
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
 
 using namespace Project;
 using namespace delameta;
@@ -9,6 +12,132 @@ using namespace delameta;
 using etl::Err;
 using etl::Ok;
 
+Deadline delameta::earliest(Deadline a, Deadline b) {
+    if (a == Deadline{}) return b;
+    if (b == Deadline{}) return a;
+    return std::min(a, b);
+}
+
+int delameta::timeout_left(int timeout_ms, Deadline deadline) {
+    if (deadline == Deadline{}) return timeout_ms;
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0) return 0;
+
+    auto res = std::min<int64_t>(left, std::numeric_limits<int>::max());
+    return timeout_ms < 0 ? int(res) : std::min(timeout_ms, int(res));
+}
+
+auto Descriptor::read_buffer() -> Result<Buffer> {
+    auto [data, err] = read();
+    if (err) return Err(std::move(*err));
+
+    auto res = Buffer::acquire(data->size());
+    std::copy(data->begin(), data->end(), res.begin());
+    return Ok(std::move(res));
+}
+
+auto Descriptor::read_into(uint8_t*, size_t, Deadline) -> Result<size_t> {
+    return Err("Reading into a caller buffer is not supported");
+}
+
+auto Descriptor::writev(const std::string_view* data, size_t n) -> Result<void> {
+    if (n == 1) return write(data[0]);
+
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += data[i].size();
+    if (total == 0) return Ok();
+
+    // one write of the joined pieces, e.g. a single TLS record instead of one per piece
+    auto joined = Buffer::acquire(total);
+    auto ptr = joined.data();
+    for (size_t i = 0; i < n; ++i) ptr = std::copy(data[i].begin(), data[i].end(), ptr);
+    return write(std::string_view(joined));
+}
+
+auto Descriptor::write_from_fd(int, size_t, int64_t) -> Result<size_t> {
+    return Err("Zero copy write is not supported");
+}
+
+StreamRules::StreamRules(StreamRules&& other) noexcept {
+    other.release_retired();
+    overflow = std::move(other.overflow);
+    for (size_t i = other.head; i < other.tail; ++i) {
+        new (slots() + tail++) StreamRule(std::move(other.slots()[i]));
+        other.slots()[i].~StreamRule();
+    }
+    other.head = other.tail = 0;
+}
+
+StreamRules& StreamRules::operator=(StreamRules&& other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    other.release_retired();
+    for (size_t i = other.head; i < other.tail; ++i) {
+        new (slots() + tail++) StreamRule(std::move(other.slots()[i]));
+        other.slots()[i].~StreamRule();
+    }
+    other.head = other.tail = 0;
+    overflow = std::move(other.overflow);
+    return *this;
+}
+
+void StreamRules::push_back(StreamRule rule) {
+    // once rules are waiting in the overflow, new ones have to queue behind them
+    if (tail < inline_capacity and (not overflow or overflow->size() == size_t(retired_in_overflow))) {
+        new (slots() + tail++) StreamRule(std::move(rule));
+        return;
+    }
+
+    if (not overflow) overflow = std::make_unique<std::deque<StreamRule>>();
+    overflow->push_back(std::move(rule));
+}
+
+void StreamRules::pop_front() {
+    release_retired();
+    if (head < tail) {
+        slots()[head++].~StreamRule();
+        if (head == tail) head = tail = 0;
+    } else {
+        overflow->pop_front();
+    }
+}
+
+void StreamRules::retire_front() {
+    release_retired();
+    if (head < tail) {
+        retired = head++;
+    } else {
+        retired_in_overflow = true;
+    }
+}
+
+void StreamRules::release_retired() {
+    if (retired >= 0) {
+        slots()[retired].~StreamRule();
+        retired = -1;
+        if (head == tail) head = tail = 0;
+    }
+    if (retired_in_overflow) {
+        overflow->pop_front();
+        retired_in_overflow = false;
+    }
+}
+
+void StreamRules::append(StreamRules&& other) {
+    while (not other.empty()) {
+        push_back(std::move(other.front()));
+        other.pop_front();
+    }
+}
+
+void StreamRules::clear() {
+    release_retired();
+    for (size_t i = head; i < tail; ++i) slots()[i].~StreamRule();
+    head = tail = 0;
+    if (overflow) overflow->clear();
+}
+
 Stream::~Stream() {
     if (at_destructor) at_destructor();
 }
@@ -47,7 +176,7 @@ Stream& Stream::operator<<(Stream& other) {
         f1();
         if (f2) f2();
     };
-    return (rules.splice(rules.end(), std::move(other.rules)), *this);
+    return (rules.append(std::move(other.rules)), *this);
 }
 
 Stream& Stream::operator<<(Stream&& other) {
@@ -56,7 +185,7 @@ Stream& Stream::operator<<(Stream&& other) {
         f1();
         if (f2) f2();
     };
-    return (rules.splice(rules.end(), std::move(other.rules)), *this);
+    return (rules.append(std::move(other.rules)), *this);
 }
 
 Stream& Stream::operator>>(Stream& other) {
@@ -83,23 +212,130 @@ Stream& Stream::operator>>(std::function<void(std::string_view)> out) {
 }
 
 Stream& Stream::operator<<(Descriptor& des) {
-    rules.emplace_back([&des, data = std::vector<uint8_t>()](Stream&) mutable {
-        auto res = des.read();
+    rules.emplace_back([&des, data = Buffer()](Stream&) mutable {
+        auto res = des.read_buffer();
         if (res.is_err()) return std::string_view{};
         data = std::move(res.unwrap());
-        return std::string_view{reinterpret_cast<const char*>(data.data()), data.size()};
+        return std::string_view(data);
     });
     return *this;
 }
 
+namespace {
+    // stands in as the sink of a stream and forwards to `des`. the output held back by the owner goes out first, so a
+    // rule that writes to the sink by itself keeps the order of the outputs
+    class SinkForwarder : public Descriptor {
+    public:
+        explicit SinkForwarder(Descriptor& des) : des(des) {}
+
+        virtual Result<void> flush() = 0;
+
+        Result<std::vector<uint8_t>> read() override { return des.read(); }
+        Result<std::vector<uint8_t>> read_until(size_t n) override { return des.read_until(n); }
+        Result<Buffer> read_buffer() override { return des.read_buffer(); }
+        Result<size_t> read_into(uint8_t* buf, size_t cap, Deadline deadline) override { return des.read_into(buf, cap, deadline); }
+        Stream read_as_stream(size_t n) override { return des.read_as_stream(n); }
+
+        Result<void> write(std::string_view data) override {
+            auto [_, err] = flush();
+            if (err) return Err(std::move(*err));
+            return des.write(data);
+        }
+
+        Result<void> writev(const std::string_view* data, size_t n) override {
+            auto [_, err] = flush();
+            if (err) return Err(std::move(*err));
+            return des.writev(data, n);
+        }
+
+        Result<size_t> write_from_fd(int fd, size_t n, int64_t offset = -1) override {
+            auto [_, err] = flush();
+            if (err) return Err(std::move(*err));
+            return des.write_from_fd(fd, n, offset);
+        }
+
+    protected:
+        Descriptor& des;
+    };
+
+    // collects the outputs of consecutive rules and hands them to the descriptor in one writev()
+    class GatherWriter : public SinkForwarder {
+    public:
+        static constexpr size_t max_pieces = 64;
+        static constexpr size_t max_bytes = 64 * 1024;
+
+        using SinkForwarder::SinkForwarder;
+
+        bool push(std::string_view data) {
+            if (data.empty()) return true;
+            pieces[n_pieces++] = data;
+            n_bytes += data.size();
+            return n_pieces < max_pieces and n_bytes < max_bytes;
+        }
+
+        Result<void> flush() override {
+            if (n_pieces == 0) return Ok();
+            auto res = des.writev(pieces.data(), n_pieces);
+            n_pieces = n_bytes = 0;
+            return res;
+        }
+
+        // the pieces join the pending outputs in the same gather write
+        Result<void> writev(const std::string_view* data, size_t n) override {
+            if (n_pieces + n > max_pieces) return SinkForwarder::writev(data, n);
+
+            for (size_t i = 0; i < n; ++i) push(data[i]);
+            return flush();
+        }
+
+    private:
+        std::array<std::string_view, max_pieces> pieces;
+        size_t n_pieces = 0;
+        size_t n_bytes = 0;
+    };
+
+    // the sink of the input of coalesce(), the merged bytes so far are written before anything else
+    class CoalesceWriter : public SinkForwarder {
+    public:
+        CoalesceWriter(Descriptor& des, std::string& buffer) : SinkForwarder(des), buffer(buffer) {}
+
+        Result<void> flush() override {
+            if (buffer.empty()) return Ok();
+            auto res = des.write(buffer);
+            buffer.clear();
+            return res;
+        }
+
+    private:
+        std::string& buffer;
+    };
+}
+
 Stream& Stream::operator>>(Descriptor& des) {
-    while (!rules.empty()) {
+    GatherWriter writer(des);
+    size_t n_pending = 0; // rules at the front whose outputs wait in `writer`, they are popped once it is flushed
+    auto prev_sink = std::exchange(sink, &writer);
+
+    bool ok = true;
+    while (ok and n_pending < rules.size()) {
         again = false;
-        auto data = rules.front()(*this);
-        auto res = des.write(data);
-        if (res.is_err()) return *this;
-        if (!again) rules.pop_front();
+        auto data = rules[n_pending](*this);
+        bool has_room = writer.push(data);
+        if (!again) ++n_pending;
+
+        // a rule that runs again may reuse the storage of its last output, so that output has to go out first
+        if (again or not has_room) {
+            ok = writer.flush().is_ok();
+            for (; ok and n_pending > 0; --n_pending) rules.pop_front();
+        }
     }
+
+    // the rules whose output didn't make it stay in the stream
+    if (ok and writer.flush().is_ok()) {
+        for (; n_pending > 0; --n_pending) rules.pop_front();
+    }
+
+    sink = prev_sink;
     return *this;
 }
 
@@ -120,15 +356,64 @@ Result<void> Stream::out_with_prefix(Descriptor& des, std::function<Result<void>
 }
 
 std::vector<uint8_t> Stream::pop_once() {
+    auto data = pop_view();
+    return {data.begin(), data.end()};
+}
+
+std::string_view Stream::pop_view() {
     if (rules.empty()) return {};
 
     again = false;
     auto data = rules.front()(*this);
+    if (!again) rules.retire_front();
+
+    return data;
+}
+
+Stream delameta::coalesce(Stream& inp, size_t high_water) {
+    Stream s;
+
+    auto input = new Stream(std::move(inp));
+    s << [input, high_water, buffer=std::string(), pending=std::string_view()](Stream& s) mutable -> std::string_view {
+        // the previous output has been consumed by now
+        buffer.clear();
+
+        // a big output that came right after some merged bytes
+        if (not pending.empty()) {
+            s.again = not input->rules.empty();
+            return std::exchange(pending, {});
+        }
 
-    std::vector<uint8_t> res {data.begin(), data.end()};
-    if (!again) rules.pop_front();
+        std::optional<CoalesceWriter> writer;
+        if (s.sink) input->sink = &writer.emplace(*s.sink, buffer);
+
+        std::string_view res = {};
+        while (not input->rules.empty() and not input->failed) {
+            auto data = input->pop_view();
+            if (data.size() >= high_water) {
+                if (buffer.empty()) {
+                    res = data;
+                } else {
+                    pending = data;
+                    res = buffer;
+                }
+                break;
+            }
+
+            buffer += data;
+            res = buffer;
+            if (buffer.size() >= high_water) break;
+        }
+
+        input->sink = nullptr;
+        s.failed = s.failed or input->failed;
+        s.again = (not input->rules.empty() and not input->failed) or not pending.empty();
+        return res;
+    };
+
+    s.at_destructor = [input]() { delete input; };
 
-    return res;
+    return s;
 }
 
 StreamSessionServer::StreamSessionServer(StreamSessionHandler handler) : handler(std::move(handler)) {}
@@ -147,7 +432,8 @@ StreamSessionClient::StreamSessionClient(Descriptor& desc)
 
 StreamSessionClient::StreamSessionClient(StreamSessionClient&& other) 
     : desc(std::exchange(other.desc, nullptr)) 
-    , is_dyn(other.is_dyn) {}
+    , is_dyn(other.is_dyn)
+    , request_timeout_ms(other.request_timeout_ms) {}
 
 StreamSessionClient::~StreamSessionClient() {
     if (desc && is_dyn) {
@@ -160,6 +446,7 @@ auto StreamSessionClient::request(Stream& in_stream) -> Result<std::vector<uint8
         PANIC("Fatal error: No descriptor created in the session");
     }
 
+    DeadlineScope scope(*desc, request_timeout_ms);
     in_stream >> *desc;
     return desc->read();
 }
@@ -178,6 +465,17 @@ auto StringViewDescriptor::read_until(size_t n) -> Result<std::vector<uint8_t>>
     return Ok(std::move(res));
 }
 
+auto StringViewDescriptor::read_into(uint8_t* buf, size_t cap, Deadline) -> Result<size_t> {
+    if (sv.empty() and cap > 0) {
+        return Err(Error::ConnectionClosed);
+    }
+
+    auto n = std::min(cap, sv.size());
+    std::copy(sv.begin(), sv.begin() + n, buf);
+    sv = sv.substr(n);
+    return Ok(n);
+}
+
 auto StringViewDescriptor::read_as_stream(size_t n) -> Stream {
     Stream s;
     s << sv.substr(0, n);
@@ -232,7 +530,7 @@ auto StringStream::read_until(size_t n) -> Result<std::vector<uint8_t>> {
 
 auto StringStream::read_as_stream(size_t n) -> Stream {
     Stream s;
-    s << [buffer=std::move(buffer), data=std::string(), n](Stream& s) mutable -> std::string_view {
+    s << [this, data=std::string(), n](Stream& s) mutable -> std::string_view {
         if (buffer.empty()) {
             return {};
         }
@@ -240,8 +538,8 @@ auto StringStream::read_as_stream(size_t n) -> Stream {
         auto &front = buffer.front();
         auto front_size = front.size();
         if (front_size > n) {
+            data = front.substr(0, n);
             front = front.substr(n);
-            data = front;
             n = 0;
         } else {
             data = front;
@@ -0,0 +1,51 @@
+#include <delameta/buffer.h>
+#include <delameta/stream.h>
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace Project;
+using delameta::Buffer;
+using delameta::Stream;
+using delameta::StringViewDescriptor;
+
+TEST(Buffer, reuse) {
+    const uint8_t* first;
+    {
+        auto buf = Buffer::acquire(100);
+        EXPECT_EQ(buf.size(), 100);
+        first = buf.data();
+    }
+    auto pooled = Buffer::pooled();
+    EXPECT_GE(pooled, 1);
+
+    auto buf = Buffer::acquire(50);
+    EXPECT_EQ(buf.data(), first);
+    EXPECT_EQ(buf.size(), 50);
+    EXPECT_EQ(Buffer::pooled(), pooled - 1);
+}
+
+TEST(Buffer, refcount) {
+    auto a = Buffer::acquire(5);
+    std::memcpy(a.data(), "hello", 5);
+    EXPECT_EQ(a.use_count(), 1);
+
+    auto b = a;
+    EXPECT_EQ(a.use_count(), 2);
+    EXPECT_EQ(b.data(), a.data());
+    EXPECT_EQ(std::string_view(b), "hello");
+
+    auto c = std::move(b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(c.use_count(), 2);
+
+    a = Buffer();
+    EXPECT_EQ(c.use_count(), 1);
+    EXPECT_EQ(std::string_view(c), "hello");
+}
+
+TEST(Buffer, read_buffer) {
+    StringViewDescriptor desc("some data");
+    auto res = desc.read_buffer();
+    ASSERT_TRUE(res.is_ok());
+    EXPECT_EQ(std::string_view(res.unwrap()), "some data");
+}
@@ -0,0 +1,79 @@
+#include <delameta/debug.h>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Project;
+using delameta::AsyncLog;
+using delameta::LogLevel;
+
+TEST(Debug, log_level) {
+    auto level = delameta::get_log_level();
+    EXPECT_EQ(level, LogLevel::Warning);
+
+    delameta::set_log_level(LogLevel::Warning);
+    EXPECT_FALSE(delameta::log_enabled(LogLevel::Info));
+    EXPECT_TRUE(delameta::log_enabled(LogLevel::Warning));
+
+    int formatted = 0;
+    auto msg = [&]() { ++formatted; return std::string("message"); };
+    INFO(msg());
+    INFO_AT("file.cpp", 1, msg());
+    EXPECT_EQ(formatted, 0);
+
+    delameta::set_log_level(LogLevel::Off);
+    EXPECT_FALSE(delameta::log_enabled(LogLevel::Warning));
+
+    delameta::set_log_level(level);
+}
+
+TEST(Debug, async_log) {
+    std::mutex mutex;
+    std::vector<std::string> lines;
+    std::thread::id sink_thread;
+
+    AsyncLog log([&](LogLevel level, const char*, int line, const std::string& msg) {
+        std::lock_guard lock(mutex);
+        sink_thread = std::this_thread::get_id();
+        lines.push_back((level == LogLevel::Info ? "I" : "W") + std::to_string(line) + ":" + msg);
+    }, 256);
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+        producers.emplace_back([&log, i]() {
+            for (int j = 0; j < 50; ++j) {
+                while (not log.push(LogLevel::Info, __FILE__, i, std::to_string(j))) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    log.push(LogLevel::Warning, __FILE__, 9, "done");
+    log.flush();
+
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(lines.size(), 201);
+    EXPECT_EQ(lines.back(), "W9:done");
+    EXPECT_NE(sink_thread, std::this_thread::get_id());
+
+    // messages of one producer keep their order
+    int next = 0;
+    for (auto& line : lines) if (line.rfind("I2:", 0) == 0) EXPECT_EQ(line, "I2:" + std::to_string(next++));
+    EXPECT_EQ(next, 50);
+}
+
+TEST(Debug, async_log_full) {
+    std::mutex blocked;
+    blocked.lock();
+
+    AsyncLog log([&](LogLevel, const char*, int, const std::string&) {
+        std::lock_guard lock(blocked);
+    }, 4);
+
+    int pushed = 0;
+    for (int i = 0; i < 16; ++i) pushed += log.push(LogLevel::Info, __FILE__, __LINE__, "x");
+
+    EXPECT_LT(pushed, 16);
+    EXPECT_EQ(log.dropped(), uint64_t(16 - pushed));
+    blocked.unlock();
+}
@@ -2,6 +2,8 @@
 #include <delameta/http/chunked.h>
 #include <delameta/utils.h>
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
 
 using namespace Project;
 using namespace delameta::http;
@@ -78,6 +80,84 @@ TEST(Http, response) {
     EXPECT_EQ(delameta::collect_into<std::string>(res.body_stream.pop_once()), body);
 }
 
+TEST(Http, head_parser) {
+    std::string_view head = "GET /index HTTP/1.1\r\nHost: example.com\nAccept: */*\r\n\r\nbody";
+    auto head_size = head.find("body");
+
+    HeadParser parser;
+    for (size_t i = 0; i < head_size; ++i) {
+        EXPECT_EQ(parser.feed(head.substr(0, i)), HeadParser::Partial);
+    }
+    EXPECT_EQ(parser.feed(head), HeadParser::Complete);
+    EXPECT_EQ(parser.head_size(), head_size);
+    EXPECT_EQ(parser.header_count(), 2);
+
+    parser = HeadParser(HeadLimits{.max_head_size=16});
+    EXPECT_EQ(parser.feed(head), HeadParser::TooLarge);
+
+    parser = HeadParser(HeadLimits{.max_header_count=1});
+    EXPECT_EQ(parser.feed(head), HeadParser::TooManyHeaders);
+}
+
+TEST(Http, head_limits) {
+    Http handler;
+    handler.head_limits.max_head_size = 64;
+
+    handler.Get("/test")|
+    []() { return "ok"; };
+
+    {
+        // the head arrives in pieces
+        StringStream ss;
+        ss.write("GET /test HT");
+        ss.write("TP/1.1\r\nHost: localhost\r");
+        ss.write("\n\r\n");
+        auto [req, res] = handler.execute(ss);
+
+        EXPECT_EQ(req.error_status, 0);
+        EXPECT_EQ(req.headers.at("Host"), "localhost");
+        EXPECT_EQ(res.status, StatusOK);
+        EXPECT_EQ(res.body, "ok");
+    } {
+        StringStream ss;
+        ss.write("GET /test HTTP/1.1\r\n");
+        ss.write("Cookie: " + std::string(64, 'x') + "\r\n\r\n");
+        auto [req, res] = handler.execute(ss);
+
+        EXPECT_EQ(req.error_status, StatusRequestHeaderFieldsTooLarge);
+        EXPECT_EQ(res.status, StatusRequestHeaderFieldsTooLarge);
+        EXPECT_EQ(res.version, "HTTP/1.1");
+    }
+}
+
+TEST(Http, header_scan) {
+    auto isa = get_scan_isa();
+
+    for (auto scan_isa : {ScanIsa::Scalar, ScanIsa::SSE42, ScanIsa::AVX2}) {
+        set_scan_isa(scan_isa);
+
+        // every length around the vector widths
+        for (size_t n = 0; n < 80; ++n) {
+            EXPECT_EQ(token_length(std::string(n, 'a') + ":" + std::string(40, 'b')), n);
+            EXPECT_EQ(field_value_length(std::string(n, 'v') + " \t\x80\r\n" + std::string(40, 'v')), n + 3);
+        }
+
+        EXPECT_EQ(token_length("Content-Type: text/plain"), 12);
+        EXPECT_EQ(token_length("X-Custom_Header!#$%&'*+.^`|~ "), 28);
+        EXPECT_EQ(token_length("Bad(Name)"), 3);
+        EXPECT_EQ(field_value_length("text/plain; charset=utf-8\x7f"), 25);
+        EXPECT_EQ(field_value_length("abc\0def"), 3);
+    }
+
+    set_scan_isa(isa);
+
+    StringStream ss;
+    ss.write("GET /test HTTP/1.1\r\nHost:\tlocalhost \r\nBad Name: value\r\n\r\n");
+    RequestReader req(ss, {});
+    EXPECT_EQ(req.headers.at("Host"), "localhost");
+    EXPECT_EQ(req.error_status, StatusBadRequest);
+}
+
 TEST(Http, handler) {
     Http handler;
 
@@ -149,6 +229,185 @@ TEST(Http, handler) {
     }
 }
 
+TEST(Http, router) {
+    Http handler;
+
+    handler.Get("/device/{id}/registers").args(arg::path_param("id"))|
+    [](int id) { return "registers of " + std::to_string(id); };
+
+    handler.Get("/device/list")|
+    []() { return "list"; };
+
+    handler.route("/device/{key}", {"GET", "DELETE"}).args(arg::method, arg::path_param("key"))|
+    [](std::string method, std::string key) { return method + " " + key; };
+
+    handler.Get("/files/{path*}").args(arg::path_param("path"))|
+    [](std::string path) { return "file " + path; };
+
+    auto execute = [&](std::string start_line) {
+        StringStream ss;
+        ss.write(start_line + " HTTP/1.1\r\n\r\n");
+        auto [req, res] = handler.execute(ss);
+        return std::make_pair(res.status, res.body);
+    };
+
+    EXPECT_EQ(execute("GET /device/7/registers"), std::make_pair(200, "registers of 7"s));
+    EXPECT_EQ(execute("GET /device/list"), std::make_pair(200, "list"s));
+    EXPECT_EQ(execute("GET /device/lis"), std::make_pair(200, "GET lis"s));
+    EXPECT_EQ(execute("DELETE /device/7"), std::make_pair(200, "DELETE 7"s));
+    EXPECT_EQ(execute("GET /files/a/b.txt"), std::make_pair(200, "file a/b.txt"s));
+    EXPECT_EQ(execute("POST /device/7").first, StatusMethodNotAllowed);
+    EXPECT_EQ(execute("GET /device/x/registers").first, StatusBadRequest);
+    EXPECT_EQ(execute("GET /device").first, StatusNotFound);
+
+    // the parameters stay readable after the request is moved out of execute()
+    StringStream ss;
+    ss.write("GET /device/7 HTTP/1.1\r\n\r\n");
+    auto [req, res] = handler.execute(ss);
+    EXPECT_EQ(req.path_param("key"), "7");
+
+    // a reroute sees the parameters of its own path and leaves the ones of the request intact
+    std::string seen;
+    handler.Get("/alias/{name}").args(arg::request, arg::response)|
+    [&](const RequestReader& req, ResponseWriter& res) {
+        auto name = std::string(*req.path_param("name"));
+        handler.reroute("/device/" + name + "-alias", req, res);
+        seen = name + " " + std::string(*req.path_param("name"));
+    };
+    EXPECT_EQ(execute("GET /alias/x"), std::make_pair(200, "GET x-alias"s));
+    EXPECT_EQ(seen, "x x");
+
+    // patterns that come from a client are rejected, not fatal
+    EXPECT_FALSE(RouteTree::is_valid("/a{b"));
+    EXPECT_FALSE(RouteTree::is_valid("/x/{n}.txt"));
+    EXPECT_FALSE(RouteTree::is_valid("/x/{}"));
+    EXPECT_FALSE(RouteTree::is_valid("/x/{a*}/b"));
+    EXPECT_FALSE(RouteTree::is_valid("/{a}/{b}/{c}/{d}/{e}/{f}/{g}/{h}/{i}"));
+    EXPECT_TRUE(handler.routers.insert("/a{b", Router{{"GET"}, [](const RequestReader&, ResponseWriter&) {}}).is_err());
+    EXPECT_FALSE(handler.routers.contains("/static/{x"));
+    EXPECT_EQ(handler.routers.erase("/x/{n}.txt"), 0u);
+
+    EXPECT_TRUE(handler.routers.contains("/device/{id}"));
+    EXPECT_EQ(handler.routers.erase("/device/{id}", "DELETE"), 1u);
+    EXPECT_EQ(execute("DELETE /device/7").first, StatusNotFound);
+}
+
+TEST(Http, normalize_path) {
+    EXPECT_EQ(normalize_path("/").unwrap(), "");
+    EXPECT_EQ(normalize_path("a//b/./c/").unwrap(), "a/b/c");
+    EXPECT_EQ(normalize_path("a/b/../c").unwrap(), "a/c");
+    EXPECT_EQ(normalize_path("my%20file.txt").unwrap(), "my file.txt");
+    EXPECT_TRUE(normalize_path("a/../..").is_err());
+    EXPECT_TRUE(normalize_path("%2e%2e/etc/passwd").is_err());
+    EXPECT_TRUE(normalize_path("a%00.txt").is_err());
+    EXPECT_TRUE(normalize_path("a\\..\\b").is_err());
+}
+
+TEST(Http, static_mount) {
+    namespace fs = std::filesystem;
+    auto root = fs::temp_directory_path() / "delameta_static_mount";
+    fs::create_directories(root / "docs");
+    auto write_file = [](const fs::path& path, std::string_view content) {
+        std::ofstream(path) << content;
+    };
+    write_file(root / "index.html", "home");
+    write_file(root / "docs" / "index.html", "docs");
+    write_file(root / "docs" / "a.txt", "a");
+
+    Http handler;
+    ASSERT_TRUE(handler.Static("/static/", root.string(), {.mount=true, .cache_size=2, .revalidate_ms=0}).is_ok());
+    EXPECT_EQ(handler.routers.size(), 2u);
+
+    auto execute = [&](std::string path) {
+        StringStream ss;
+        ss.write("GET " + path + " HTTP/1.1\r\n\r\n");
+        auto [req, res] = handler.execute(ss);
+        std::string body;
+        res.body_stream >> [&](std::string_view sv) { body += sv; };
+        return std::make_pair(res.status, body);
+    };
+
+    EXPECT_EQ(execute("/static"), std::make_pair(200, "home"s));
+    EXPECT_EQ(execute("/static/docs/"), std::make_pair(200, "docs"s));
+    EXPECT_EQ(execute("/static/docs/./a.txt"), std::make_pair(200, "a"s));
+    EXPECT_EQ(execute("/static/b.txt").first, StatusNotFound);
+    EXPECT_EQ(execute("/static/../etc/passwd").first, StatusBadRequest);
+
+    // found without a restart, changed and gone even though it was cached
+    write_file(root / "b.txt", "b");
+    EXPECT_EQ(execute("/static/b.txt"), std::make_pair(200, "b"s));
+    write_file(root / "b.txt", "bb");
+    EXPECT_EQ(execute("/static/b.txt"), std::make_pair(200, "bb"s));
+    fs::remove(root / "b.txt");
+    EXPECT_EQ(execute("/static/b.txt").first, StatusNotFound);
+
+    // two responses read the same cached file at the same time
+    std::string big(1000, 'x');
+    for (size_t i = 0; i < big.size(); ++i) big[i] = 'a' + i % 26;
+    write_file(root / "big.txt", big);
+
+    StringStream ss;
+    ss.write("GET /static/big.txt HTTP/1.1\r\n\r\n");
+    auto [req1, res1] = handler.execute(ss);
+    ss.write("GET /static/big.txt HTTP/1.1\r\n\r\n");
+    auto [req2, res2] = handler.execute(ss);
+    EXPECT_EQ(res1.headers.at("Content-Length"), "1000");
+
+    std::string body1, body2;
+    while (not res1.body_stream.rules.empty() or not res2.body_stream.rules.empty()) {
+        if (not res1.body_stream.rules.empty()) body1 += res1.body_stream.pop_view();
+        if (not res2.body_stream.rules.empty()) body2 += res2.body_stream.pop_view();
+    }
+    EXPECT_EQ(body1, big);
+    EXPECT_EQ(body2, big);
+
+    // a file cut short under a response fails its stream and leaves the cache, even before it is revalidated
+    Http cached;
+    ASSERT_TRUE(cached.Static("/", root.string(), {.mount=true, .revalidate_ms=60 * 1000}).is_ok());
+    ss.write("GET /big.txt HTTP/1.1\r\n\r\n");
+    auto [req3, res3] = cached.execute(ss);
+    fs::resize_file(root / "big.txt", 10);
+
+    std::string body3;
+    res3.body_stream >> [&](std::string_view sv) { body3 += sv; };
+    EXPECT_EQ(body3, big.substr(0, 10));
+    EXPECT_TRUE(res3.body_stream.failed);
+
+    ss.write("GET /big.txt HTTP/1.1\r\n\r\n");
+    auto [req4, res4] = cached.execute(ss);
+    EXPECT_EQ(res4.headers.at("Content-Length"), "10");
+
+    fs::remove_all(root);
+}
+
+TEST(Http, static_braces) {
+    namespace fs = std::filesystem;
+    auto root = fs::temp_directory_path() / "delameta_static_braces";
+    fs::create_directories(root);
+    std::ofstream(root / "a.txt") << "a";
+    std::ofstream(root / "{id}") << "id";
+    std::ofstream(root / "a{b}.txt") << "ab";
+
+    // file names with braces are skipped, they are neither a parameter route nor a fatal pattern
+    Http handler;
+    ASSERT_TRUE(handler.Static("/static/", root.string()).is_ok());
+    EXPECT_EQ(handler.routers.size(), 1u);
+
+    auto execute = [&](std::string path) {
+        StringStream ss;
+        ss.write("GET " + path + " HTTP/1.1\r\n\r\n");
+        auto [req, res] = handler.execute(ss);
+        std::string body;
+        res.body_stream >> [&](std::string_view sv) { body += sv; };
+        return std::make_pair(res.status, body);
+    };
+
+    EXPECT_EQ(execute("/static/a.txt"), std::make_pair(200, "a"s));
+    EXPECT_EQ(execute("/static/b.txt").first, StatusNotFound);
+
+    fs::remove_all(root);
+}
+
 TEST(Http, json) {
     Http handler;
 
@@ -240,37 +499,64 @@ TEST(Http, chunked) {
     EXPECT_EQ(res.headers.at("Transfer-Encoding"), "chunked");
     EXPECT_EQ(res.headers.at("Content-Type"), "application/json");
 
+    // the json parts are coalesced into one chunk
     int idx = 0;
     res.body_stream >> [&](std::string_view sv) {
         ss.write(sv);
-        if (idx == 0) { EXPECT_EQ(sv, "10\r\n{\"name\":\"Jupri\",\r\n"sv); }
-        if (idx == 1) { EXPECT_EQ(sv, "9\r\n\"age\":19,\r\n"sv); }
-        if (idx == 2) { EXPECT_EQ(sv, "12\r\n\"is_married\":true,\r\n"sv); }
-        if (idx == 3) { EXPECT_EQ(sv, "F\r\n\"salary\":9.100,\r\n"sv); }
-        if (idx == 4) { EXPECT_EQ(sv, "C\r\n\"role\":null}\r\n"sv); }
-        if (idx == 5) { EXPECT_EQ(sv, "0\r\n\r\n"sv); }
+        if (idx == 0) { EXPECT_EQ(sv, "46\r\n{\"name\":\"Jupri\",\"age\":19,\"is_married\":true,\"salary\":9.100,\"role\":null}\r\n"sv); }
+        if (idx == 1) { EXPECT_EQ(sv, "0\r\n\r\n"sv); }
         ++idx;
     };
 
-    EXPECT_EQ(idx, 6);
-    EXPECT_EQ(ss.buffer.size(), 6);
+    EXPECT_EQ(idx, 2);
+    EXPECT_EQ(ss.buffer.size(), 2);
 
     Stream s;
     s = chunked_decode(ss);
     idx = 0;
 
     s >> [&](std::string_view sv) {
-        if (idx == 0) { EXPECT_EQ(sv, "{\"name\":\"Jupri\","sv); }
-        if (idx == 1) { EXPECT_EQ(sv, "\"age\":19,"sv); }
-        if (idx == 2) { EXPECT_EQ(sv, "\"is_married\":true,"sv); }
-        if (idx == 3) { EXPECT_EQ(sv, "\"salary\":9.100,"sv); }
-        if (idx == 4) { EXPECT_EQ(sv, "\"role\":null}"sv); }
-        if (idx == 5) { EXPECT_EQ(sv, ""sv); }
+        if (idx == 0) { EXPECT_EQ(sv, "{\"name\":\"Jupri\",\"age\":19,\"is_married\":true,\"salary\":9.100,\"role\":null}"sv); }
+        if (idx == 1) { EXPECT_EQ(sv, ""sv); }
         ++idx;
     };
 
-    EXPECT_EQ(idx, 6);
+    EXPECT_EQ(idx, 2);
     EXPECT_EQ(ss.buffer.size(), 0);
+
+    // without coalescing every part is a chunk of its own
+    handler.coalesce_size = 0;
+    ss.write("GET / HTTP/1.1\r\n\r\n");
+    auto [req2, res2] = handler.execute(ss);
+
+    std::vector<std::string> chunks;
+    res2.body_stream >> [&](std::string_view sv) { chunks.emplace_back(sv); };
+
+    ASSERT_EQ(chunks.size(), 6);
+    EXPECT_EQ(chunks[0], "10\r\n{\"name\":\"Jupri\",\r\n");
+    EXPECT_EQ(chunks[5], "0\r\n\r\n");
+
+    // a response can opt out of coalescing on its own
+    handler.coalesce_size = 16 * 1024;
+    handler.Get("/stream").args(arg::request, arg::response)|
+    [](const RequestReader&, ResponseWriter& res) {
+        res.coalesce = false;
+        res.headers["Content-Type"] = "application/x-ndjson";
+        for (auto line : {"{\"n\":1}\n", "{\"n\":2}\n"}) {
+            res.body_stream << std::string(line);
+        }
+    };
+
+    ss.write("GET /stream HTTP/1.1\r\n\r\n");
+    auto [req3, res3] = handler.execute(ss);
+
+    chunks.clear();
+    res3.body_stream >> [&](std::string_view sv) { chunks.emplace_back(sv); };
+
+    ASSERT_EQ(chunks.size(), 3);
+    EXPECT_EQ(chunks[0], "8\r\n{\"n\":1}\n\r\n");
+    EXPECT_EQ(chunks[1], "8\r\n{\"n\":2}\n\r\n");
+    EXPECT_EQ(chunks[2], "0\r\n\r\n");
 }
 
 TEST(Http, client) {
@@ -377,5 +663,62 @@ TEST(Http, chunked_decode) {
 
         EXPECT_EQ(res, "{\"name\":\"Jupri\",\"age\":19}"sv);
         EXPECT_EQ(idx, 3);
+    } {
+        // written into a descriptor, the part of a chunk that hasn't arrived yet is read as a stream
+        StringStream ss;
+
+        ss.write(
+            "10\r\n{\"name\":"
+        );
+        ss.write(
+            "\"Jupri\",\r\n"
+            "9\r\n\"ag"
+        );
+        ss.write(
+            "e\":19}\r\n"
+            "0\r\n\r\n"
+        );
+
+        auto s = chunked_decode(ss);
+        StringStream out;
+        s >> out;
+
+        std::string res;
+        for (auto& data : out.buffer) res += data;
+
+        EXPECT_EQ(res, "{\"name\":\"Jupri\",\"age\":19}"sv);
+    }
+}
+
+TEST(Http, chunked_encode) {
+    auto input = []() {
+        Stream s;
+        s << "{\"name\":\"Jupri\"," << std::string("\"age\":19}");
+        return s;
+    };
+
+    {
+        auto in = input();
+        auto s = chunked_encode(in);
+
+        int idx = 0;
+        std::string res;
+        s >> [&](std::string_view sv) {
+            res += sv;
+            ++idx;
+        };
+
+        EXPECT_EQ(idx, 3);
+        EXPECT_EQ(res, "10\r\n{\"name\":\"Jupri\",\r\n9\r\n\"age\":19}\r\n0\r\n\r\n"sv);
+    } {
+        // written into a descriptor, each chunk is framed by a gather write instead of being copied
+        auto in = input();
+        auto s = chunked_encode(in);
+        StringStream out;
+        s >> out;
+
+        ASSERT_EQ(out.buffer.size(), 3);
+        EXPECT_EQ(out.buffer.front(), "10\r\n{\"name\":\"Jupri\",\r\n"sv);
+        EXPECT_EQ(out.buffer.back(), "0\r\n\r\n"sv);
     }
 }
@@ -0,0 +1,123 @@
+#include <delameta/http/parser.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+// run with: test_all --gtest_also_run_disabled_tests --gtest_filter='HttpBench.*'
+
+using namespace Project;
+using namespace delameta::http;
+
+static const char* browser_headers =
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"128\", \"Not;A=Brand\";v=\"24\", \"Google Chrome\";v=\"128\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/128.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,"
+        "application/signed-exchange;v=b3;q=0.7\r\n"
+    "Sec-Fetch-Site: none\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: en-US,en;q=0.9,id;q=0.8\r\n"
+    "Cookie: _ga=GA1.1.1234567890.1723456789; session_id=3f9a8c7e6d5b4a3928171605f4e3d2c1; "
+        "_ga_ABCDEFGHIJ=GS1.1.1723456789.3.1.1723459999.0.0.0; theme=dark; consent=yes\r\n"
+    "\r\n";
+
+static const char* curl_headers =
+    "Host: localhost:5000\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+// the scanner before the vectorized one, kept to compare against
+static void legacy_parse_headers(std::string_view sv, std::unordered_map<std::string_view, std::string_view>& headers) {
+    auto consume_line = [](std::string_view& sv) {
+        size_t pos = 0;
+        for (; pos < sv.size(); ++pos) {
+            if (sv[pos] == '\n') break;
+        }
+
+        auto res = sv.substr(0, pos);
+        sv = sv.substr(pos);
+        if (sv.size() > 0 && sv[0] == '\n') sv = sv.substr(1);
+        if (res.size() > 0 && res.back() == '\r') res = res.substr(0, res.size() - 1);
+        return res;
+    };
+
+    for (;;) {
+        auto line = consume_line(sv);
+        if (line.empty()) break;
+
+        std::string_view key, value;
+        auto key_end = line.find(':');
+
+        key = line.substr(0, key_end);
+        if (key_end != std::string::npos) {
+            value = line.substr(key_end + 1);
+        } else {
+            key = line;
+        }
+
+        while (!key.empty() && key.back() == ' ') key = key.substr(0, key.size() - 1);
+        while (!value.empty() && value.front() == ' ') value = value.substr(1);
+
+        headers[key] = value;
+    }
+}
+
+// the same loop as the request and response readers
+static void scan_headers(std::string_view sv, std::unordered_map<std::string_view, std::string_view>& headers) {
+    while (sv.size() > 2) {
+        auto key = sv.substr(0, token_length(sv));
+        sv.remove_prefix(key.size() + 1);
+
+        while (not sv.empty() and sv.front() == ' ') sv.remove_prefix(1);
+        auto value = sv.substr(0, field_value_length(sv));
+        sv.remove_prefix(value.size() + 2);
+
+        headers[key] = value;
+    }
+}
+
+template <typename F>
+static double ns_per_head(const char* head, F&& parse) {
+    constexpr int iterations = 200000;
+    std::unordered_map<std::string_view, std::string_view> headers;
+    headers.reserve(16);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        headers.clear();
+        parse(std::string_view(head), headers);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_FALSE(headers.empty());
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+static void bench(const char* name, const char* head) {
+    auto isa = get_scan_isa();
+
+    std::printf("%-8s legacy %7.1f ns", name, ns_per_head(head, legacy_parse_headers));
+    for (auto [scan_isa, scan_name] : {std::pair{ScanIsa::Scalar, "scalar"}, {ScanIsa::SSE42, "sse4.2"}, {ScanIsa::AVX2, "avx2"}}) {
+        set_scan_isa(scan_isa);
+        if (get_scan_isa() != scan_isa) continue;
+        std::printf(" | %s %7.1f ns", scan_name, ns_per_head(head, scan_headers));
+    }
+    std::printf("\n");
+
+    set_scan_isa(isa);
+}
+
+TEST(HttpBench, DISABLED_header_scan) {
+    bench("browser", browser_headers);
+    bench("curl", curl_headers);
+}
@@ -1,5 +1,7 @@
 #include <delameta/stream.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 
 using namespace Project;
 using delameta::Stream;
@@ -34,3 +36,142 @@ TEST(Stream, move) {
     EXPECT_FALSE(a.at_destructor);
     EXPECT_TRUE(b.at_destructor);
 }
+
+TEST(Stream, pop_view) {
+    Stream s;
+    s << std::string("first") << [n=0, data=std::string()](Stream& self) mutable -> std::string_view {
+        data = "again " + std::to_string(n);
+        self.again = ++n < 2;
+        return data;
+    };
+
+    auto first = s.pop_view();
+    EXPECT_EQ(first, "first");
+    EXPECT_EQ(s.rules.size(), 1);
+
+    EXPECT_EQ(s.pop_view(), "again 0");
+    auto last = s.pop_view();
+    EXPECT_EQ(last, "again 1");
+    EXPECT_TRUE(s.rules.empty());
+    EXPECT_EQ(last, "again 1"); // the finished rule is still alive
+
+    EXPECT_EQ(s.pop_view(), "");
+}
+
+TEST(Stream, read_into) {
+    delameta::StringViewDescriptor desc("some data");
+    uint8_t buf[5];
+
+    auto res = desc.read_into(buf, sizeof(buf));
+    ASSERT_TRUE(res.is_ok());
+    EXPECT_EQ(std::string_view(reinterpret_cast<char*>(buf), res.unwrap()), "some ");
+
+    res = desc.read_into(buf, sizeof(buf));
+    ASSERT_TRUE(res.is_ok());
+    EXPECT_EQ(std::string_view(reinterpret_cast<char*>(buf), res.unwrap()), "data");
+
+    EXPECT_TRUE(desc.read_into(buf, sizeof(buf)).is_err());
+}
+
+TEST(Stream, deadline) {
+    using namespace std::chrono_literals;
+    auto now = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(delameta::earliest({}, now), now);
+    EXPECT_EQ(delameta::earliest(now + 1s, now), now);
+    EXPECT_EQ(delameta::timeout_left(250, {}), 250);
+    EXPECT_EQ(delameta::timeout_left(-1, now - 1ms), 0);
+    EXPECT_LE(delameta::timeout_left(5000, now + 100ms), 100);
+    EXPECT_GT(delameta::timeout_left(-1, now + 1s), 500);
+
+    EXPECT_EQ(delameta::timeout_ms_of(2, 0), 2000);
+    EXPECT_EQ(delameta::timeout_ms_of(2, 150), 150);
+    EXPECT_EQ(delameta::timeout_ms_of(-1, 0), -1);
+
+    // nested scopes only tighten the deadline, and restore it when they end
+    delameta::StringStream des;
+    {
+        delameta::DeadlineScope outer(des, 100);
+        auto deadline = des.deadline;
+        EXPECT_NE(deadline, delameta::Deadline{});
+        {
+            delameta::DeadlineScope inner(des, 10000);
+            EXPECT_EQ(des.deadline, deadline);
+        }
+        {
+            delameta::DeadlineScope inner(des, 10);
+            EXPECT_LT(des.deadline, deadline);
+        }
+        EXPECT_EQ(des.deadline, deadline);
+    }
+    EXPECT_EQ(des.deadline, delameta::Deadline{});
+}
+
+TEST(Stream, gather_write) {
+    struct Recorder : delameta::StringStream {
+        delameta::Result<void> writev(const std::string_view* data, size_t n) override {
+            ++calls;
+            return delameta::Descriptor::writev(data, n);
+        }
+        int calls = 0;
+    };
+
+    Recorder out;
+    Stream s;
+    s << "HTTP/1.1 200 OK\r\n" << std::string("Content-Length: 5\r\n\r\n") << "hello";
+    s >> out;
+
+    EXPECT_EQ(out.calls, 1);
+    ASSERT_EQ(out.buffer.size(), 1);
+    EXPECT_EQ(out.buffer.front(), "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello");
+
+    // a rule that runs again gets its previous output written before it is called again
+    Recorder out2;
+    int cnt = 0;
+    s << "a" << [&cnt, data=std::string()](Stream& self) mutable -> std::string_view {
+        data = std::to_string(cnt++);
+        self.again = cnt < 3;
+        return data;
+    } << "b";
+    s >> out2;
+
+    EXPECT_EQ(out2.calls, 3);
+    std::string res;
+    for (auto& part : out2.buffer) res += part;
+    EXPECT_EQ(res, "a012b");
+}
+
+TEST(Stream, coalesce) {
+    auto outputs_of = [](Stream s) {
+        std::vector<std::string> res;
+        s >> [&res](std::string_view data) { res.emplace_back(data); };
+        return res;
+    };
+
+    Stream s;
+    s << "ab" << "cd" << "ef";
+    auto c = delameta::coalesce(s, 4);
+    EXPECT_EQ(outputs_of(std::move(c)), (std::vector<std::string>{"abcd", "ef"}));
+
+    // a big output is handed out as is, after the bytes merged before it
+    std::string_view big = "0123456789";
+    s << "a" << big << "b";
+    auto c2 = delameta::coalesce(s, 4);
+    EXPECT_EQ(c2.pop_view(), "a");
+    EXPECT_EQ(c2.pop_view().data(), big.data());
+    EXPECT_EQ(c2.pop_view(), "b");
+    EXPECT_TRUE(c2.rules.empty());
+
+    // a rule that writes to the sink by itself gets the merged bytes written first
+    delameta::StringStream out;
+    s << "a" << [](Stream& self) -> std::string_view {
+        if (self.sink) self.sink->write("B");
+        return "";
+    } << "c";
+    auto c3 = delameta::coalesce(s);
+    c3 >> out;
+
+    std::string res;
+    for (auto& part : out.buffer) res += part;
+    EXPECT_EQ(res, "aBc");
+}
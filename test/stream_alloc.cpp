@@ -0,0 +1,64 @@
+#include <delameta/stream.h>
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// replaces the global allocator to count allocations, so it is built as its own executable (test_stream_alloc)
+// instead of being part of test_all
+
+using namespace Project;
+using delameta::Stream;
+using delameta::Descriptor;
+
+static std::atomic<size_t> allocation_count = 0;
+
+void* operator new(size_t n) {
+    ++allocation_count;
+    if (auto p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// not inlined, gcc would otherwise see the pointer of a new expression reaching free() and warn
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+TEST(Stream, allocations) {
+    struct Sink : Descriptor {
+        delameta::Result<std::vector<uint8_t>> read() override { return etl::Err("write only"); }
+        delameta::Result<std::vector<uint8_t>> read_until(size_t) override { return etl::Err("write only"); }
+        Stream read_as_stream(size_t) override { return {}; }
+        delameta::Result<void> write(std::string_view data) override { 
+            size += data.size();
+            return etl::Ok();
+        }
+        size_t size = 0;
+    };
+
+    const std::string headers = "Content-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n";
+    Sink sink;
+
+    // a typical response: status line, headers, and a body produced by a rule with some state
+    auto respond = [&]() {
+        Stream s;
+        s << "HTTP/1.1 200 OK\r\n" << std::string_view(headers);
+        s << [n=0, chunk=std::array<char, 16>()](Stream& self) mutable -> std::string_view {
+            auto len = std::snprintf(chunk.data(), chunk.size(), "3\r\n%03d\r\n", n);
+            self.again = ++n < 4;
+            return {chunk.data(), size_t(len)};
+        };
+        s << "0\r\n\r\n";
+
+        Stream moved = std::move(s);
+        moved >> sink;
+    };
+
+    respond(); // warm up the buffer pool
+    auto before = allocation_count.load();
+    for (int i = 0; i < 100; ++i) respond();
+
+    EXPECT_EQ(allocation_count - before, 0);
+    EXPECT_EQ(sink.size, 101 * (17 + headers.size() + 4 * 8 + 5));
+}